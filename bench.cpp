@@ -0,0 +1,332 @@
+/**
+ * Micro benchmarks of the core kernels, built by `make bench` and run from the code directory like the methods
+ * The fixtures are built from the instance files, scaled by replicating tasks and experts, and seeded by the master seed,
+ * so two builds run the kernels on the same inputs, e.g. `./bench 42 1 4` runs seed 42 on the instance and on 4x of it.
+ * Each kernel is repeated for at least `BENCH_MIN_TIME` seconds (0.5 by default), setup between the repeats is not measured.
+ * The methods are in their own namespaces, so their helpers of the same name do not collide
+ */
+
+#include "ga.hpp"
+#include "greedy2.hpp"
+#include "mcts.hpp"
+#include "monte_metrics.hpp"
+#include "monte_utils.hpp"
+#include "rand_utils.hpp"
+#include "spt_benchmark.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <vector>
+
+static const int MIN_OPS = 5;               // repeats of each kernel at least
+static const int MAX_OPS = 1000000;         // repeats of each kernel at most
+static const int GENERATE_TM_JITTER = 60;   // max shift of the generate time of a replicated task
+
+static std::atomic<uint64_t> NUM_ALLOCS(0);
+static std::atomic<uint64_t> NUM_ALLOC_BYTES(0);
+
+/**
+ * Count an allocation and take it from malloc, or from aligned_alloc for an over-aligned type. All forms of the global
+ * new below count through it, and all forms of the global delete free with `counted_free`, so no block is freed by
+ * another allocator than the one it came from
+ */
+__attribute__((noinline)) void *counted_alloc(size_t size, size_t align)
+{
+    NUM_ALLOCS.fetch_add(1, std::memory_order_relaxed);
+    NUM_ALLOC_BYTES.fetch_add(size, std::memory_order_relaxed);
+    size = size ? size : 1;
+    if (align <= alignof(std::max_align_t))
+        return malloc(size);
+    return aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+/**
+ * Not inlined into the deletes, so the compiler does not match the free against the replaced new
+ */
+__attribute__((noinline)) void counted_free(void *p)
+{
+    free(p);
+}
+
+void *counted_alloc_or_throw(size_t size, size_t align)
+{
+    void *p = counted_alloc(size, align);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+__attribute__((noinline)) void *operator new(size_t size)
+{
+    return counted_alloc_or_throw(size, 0);
+}
+
+void *operator new[](size_t size)
+{
+    return counted_alloc_or_throw(size, 0);
+}
+
+void *operator new(size_t size, std::align_val_t align)
+{
+    return counted_alloc_or_throw(size, (size_t)align);
+}
+
+void *operator new[](size_t size, std::align_val_t align)
+{
+    return counted_alloc_or_throw(size, (size_t)align);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return counted_alloc(size, 0);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return counted_alloc(size, 0);
+}
+
+void *operator new(size_t size, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+    return counted_alloc(size, (size_t)align);
+}
+
+void *operator new[](size_t size, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+    return counted_alloc(size, (size_t)align);
+}
+
+void operator delete(void *p) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete(void *p, size_t, std::align_val_t) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete[](void *p, size_t, std::align_val_t) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    counted_free(p);
+}
+
+/**
+ * The instance replicated `scale` times, copies get new ids and their tasks are generated a little later,
+ * tasks are sorted as the methods sort them
+ */
+struct Fixture
+{
+    int scale;
+    std::vector<monte_utils::Task> tasks;
+    std::vector<monte_utils::Expert> experts;
+    std::vector<std::vector<int>> expt_groups;
+
+    Fixture(const std::vector<monte_utils::Task> &base_tasks, const std::vector<monte_utils::Expert> &base_experts,
+            int _scale, uint64_t seed) : scale(_scale)
+    {
+        rand_utils::Xoshiro256 rng = rand_utils::job_stream(seed, scale);
+        int max_task_id = 0, max_expert_id = 0;
+        for (const monte_utils::Task &task : base_tasks)
+            max_task_id = std::max(max_task_id, task.task_id);
+        for (const monte_utils::Expert &expert : base_experts)
+            max_expert_id = std::max(max_expert_id, expert.expert_id);
+        for (int k = 0; k < scale; ++k)
+        {
+            for (const monte_utils::Task &task : base_tasks)
+            {
+                int generate_tm = task.generate_tm + (k > 0 ? rand_utils::range(rng, 0, GENERATE_TM_JITTER) : 0);
+                tasks.emplace_back(monte_utils::Task(task.task_id + k * max_task_id, generate_tm, task.type, task.max_resp));
+            }
+            for (const monte_utils::Expert &expert : base_experts)
+            {
+                experts.push_back(expert);
+                experts.back().expert_id = expert.expert_id + k * max_expert_id;
+            }
+        }
+        std::sort(tasks.begin(), tasks.end(), [](const monte_utils::Task &a, const monte_utils::Task &b) -> bool {
+            if (a.generate_tm != b.generate_tm)
+                return a.generate_tm < b.generate_tm;
+            else if (a.max_resp != b.max_resp)
+                return a.max_resp < b.max_resp;
+            else
+                return a.task_id < b.task_id;
+        });
+        expt_groups = greedy2::group_experts(experts, monte_utils::NUM_TASK_TYPE);
+    }
+};
+
+/**
+ * Time `op` until `min_time` seconds and MIN_OPS repeats are reached, `setup` runs before each repeat and is not measured
+ */
+void bench(const char *name, int scale, double min_time, const std::function<void()> &setup, const std::function<void()> &op)
+{
+    setup();
+    op(); // warm up
+    double total_ns = 0;
+    uint64_t num_allocs = 0, num_bytes = 0;
+    int num_ops = 0;
+    while ((total_ns < min_time * 1e9 || num_ops < MIN_OPS) && num_ops < MAX_OPS)
+    {
+        setup();
+        uint64_t allocs_before = NUM_ALLOCS.load(std::memory_order_relaxed);
+        uint64_t bytes_before = NUM_ALLOC_BYTES.load(std::memory_order_relaxed);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        op();
+        total_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        num_allocs += NUM_ALLOCS.load(std::memory_order_relaxed) - allocs_before;
+        num_bytes += NUM_ALLOC_BYTES.load(std::memory_order_relaxed) - bytes_before;
+        num_ops++;
+    }
+    printf("%-32s %6dx %16.1f %14.1f %16.1f %10d\n", name, scale, total_ns / num_ops, (double)num_allocs / num_ops,
+           (double)num_bytes / num_ops, num_ops);
+    fflush(stdout);
+}
+
+/**
+ * Benchmarks of the kernels on one scaled instance
+ */
+void bench_fixture(const Fixture &fx, uint64_t seed, double min_time)
+{
+    const int scale = fx.scale;
+    std::vector<monte_utils::Task> tasks;
+    std::vector<monte_utils::Expert> experts;
+
+    std::vector<std::vector<int>> groups;
+    bench("group_experts", scale, min_time, []() {}, [&]() { groups = greedy2::group_experts(fx.experts, monte_utils::NUM_TASK_TYPE); });
+
+    // greedy2: one randomized run, the final state is the fixture of score
+    greedy2::Instance instance;
+    instance.tasks = fx.tasks;
+    instance.experts = fx.experts;
+    instance.expt_groups = fx.expt_groups;
+    greedy2::Worker worker(instance);
+    int run = 0;
+    bench("greedy2::run_alg", scale, min_time, [&]() { worker.reset(instance, rand_utils::job_stream(seed, run++)); },
+          [&]() { greedy2::run_alg(worker); });
+    bench("monte_metrics::score", scale, min_time, []() {}, [&]() { monte_metrics::score(worker.tasks, worker.experts); });
+
+    // spt: the task groups point into the copied tasks
+    std::vector<std::vector<monte_utils::Task *>> group_tasks;
+    experts = fx.experts;
+    std::vector<std::vector<int>> spt_groups = spt::expert_group_by_type(monte_utils::NUM_TASK_TYPE, experts);
+    spt::expert_sort_each_group_by_processtm(spt_groups, experts);
+    bench("spt_run", scale, min_time,
+          [&]() {
+              tasks = fx.tasks;
+              experts = fx.experts;
+              group_tasks = spt::task_groupby_type(monte_utils::NUM_TASK_TYPE, tasks);
+              spt::task_sort_each_group_by_tm_resptm(group_tasks);
+          },
+          [&]() { spt::spt_run(tasks, experts, group_tasks, spt_groups); });
+
+    // ga: solutions of the initial population
+    ga::rng.seed(seed);
+    tasks = fx.tasks;
+    std::vector<std::vector<int>> ga_groups = ga::group_experts(fx.experts, monte_utils::NUM_TASK_TYPE);
+    std::vector<std::vector<int>> solutions = ga::ga_init_solutions(tasks, ga_groups);
+    std::vector<int> s;
+    ga::Decoder decoder;
+    bench("ga::convert_solution_to_result", scale, min_time, []() {},
+          [&]() { ga::convert_solution_to_result(solutions[0], fx.tasks, fx.experts, decoder); });
+    bench("ga::crossover", scale, min_time, []() {}, [&]() { s = ga::crossover(solutions[0], solutions[1]); });
+    bench("ga::mutation", scale, min_time, [&]() { s = solutions[0]; }, [&]() { ga::mutation(s, tasks, ga_groups); });
+
+    // mcts: expand from the state where half of the tasks are generated, simulate from the start
+    mcts::rng.seed(seed);
+    experts = fx.experts;
+    tasks = fx.tasks;
+    std::vector<std::vector<int>> mcts_groups = mcts::group_expert_by_type(experts, monte_utils::NUM_TASK_TYPE);
+    mcts::MCTNode *root = mcts::init_root(tasks, experts, mcts_groups);
+    mcts::MCTNode *node = new mcts::MCTNode();
+    *node = *root;
+    int half_tm = fx.tasks[fx.tasks.size() / 2].generate_tm;
+    while (node->env_tm < half_tm)
+    {
+        mcts::expand<mcts::DefaultRolloutPolicy>(node, 1);
+        mcts::MCTNode *next = node->child_nodes[0];
+        node->remove_last_child();
+        delete node;
+        node = next;
+    }
+    node->parent = nullptr;
+    bench("mcts::expand", scale, min_time, [&]() { node->clear_free_child_nodes(); }, [&]() { mcts::expand(node); });
+    node->clear_free_child_nodes();
+    delete node;
+    bench("mcts::simulate", scale, min_time, []() {}, [&]() { mcts::simulate<mcts::DefaultRolloutPolicy>(root); });
+    delete root;
+}
+
+int main(int argc, char const *argv[])
+{
+    const uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 10) : 0;
+    std::vector<int> scales;
+    for (int i = 2; i < argc; ++i)
+        scales.push_back(std::max(atoi(argv[i]), 1));
+    if (scales.empty())
+        scales = {1, 4};
+    const double min_time = getenv("BENCH_MIN_TIME") ? atof(getenv("BENCH_MIN_TIME")) : 0.5;
+    // no rollout beats this score, so rollouts are measured without extracting and logging improvements
+    mcts::BEST_BOARD.adopt(best_board::Incumbent{1e300, {}});
+    printf("seed=%llu min time=%.2lfs\n", (unsigned long long)seed, min_time);
+    printf("%-32s %7s %16s %14s %16s %10s\n", "kernel", "scale", "ns/op", "allocs/op", "bytes/op", "ops");
+
+    std::vector<monte_utils::Task> base_tasks;
+    std::vector<monte_utils::Expert> base_experts;
+    bench("load_tasks", 1, min_time, []() {}, [&]() { base_tasks = monte_utils::load_tasks(); });
+    bench("load_experts", 1, min_time, []() {}, [&]() { base_experts = monte_utils::load_experts(); });
+    for (int scale : scales)
+        bench_fixture(Fixture(base_tasks, base_experts, scale, seed), seed, min_time);
+    return 0;
+}
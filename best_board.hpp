@@ -0,0 +1,221 @@
+/**
+ * Best solution board shared by the threads of a search
+ * The best score is an atomic raced by compare and swap, so publishing a worse solution costs one atomic load,
+ * and the solution of the best score is published under a seqlock into preallocated rows, like the incumbent of
+ * shm_board.hpp, readers copy it without blocking the publisher and retry if a publish overlapped the copy.
+ * Publishers take turns, which is rare since only improving offers publish
+ */
+
+#pragma once
+#include "monte_utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace best_board
+{
+
+struct Incumbent
+{
+    double score;
+    std::vector<monte_utils::Assignment> solution;
+};
+
+/**
+ * Rows of a published solution, a buffer is never freed while the board lives, so a reader racing with a writer
+ * which replaced it still reads valid memory and only fails its sequence check
+ */
+struct RowBuffer
+{
+    size_t capacity;
+    std::unique_ptr<monte_utils::Assignment[]> rows;
+};
+
+struct BestBoard
+{
+    std::atomic<double> best_score;
+    // the published incumbent, guarded by a seqlock, `seq` is odd while a writer updates it
+    std::atomic<uint64_t> seq;
+    std::atomic<double> published_score; // -HUGE_VAL if nothing is published yet
+    std::atomic<size_t> num_rows;
+    std::atomic<const RowBuffer *> buffer;
+    std::vector<std::unique_ptr<RowBuffer>> buffers; // the current buffer and the retired ones, guarded by `seq`
+    std::function<void(const Incumbent &)> on_improve; // called by the improving thread, must be thread safe
+    std::function<void(const Incumbent &)> writer;     // called by one thread at a time, at most once every `write_interval`
+    std::chrono::duration<double> write_interval;
+    std::atomic_flag writing = ATOMIC_FLAG_INIT;
+    std::chrono::steady_clock::time_point last_write; // guarded by `writing`
+    double written_score;                             // guarded by `writing`
+
+    BestBoard(std::function<void(const Incumbent &)> _on_improve = nullptr, std::function<void(const Incumbent &)> _writer = nullptr,
+              double write_interval_sec = 0)
+        : best_score(0), seq(0), published_score(-HUGE_VAL), num_rows(0), buffer(nullptr), on_improve(_on_improve),
+          writer(_writer), write_interval(write_interval_sec), written_score(0) {}
+
+    /**
+     * The best score so far, cheap enough for pruning in inner loops
+     */
+    double score() const
+    {
+        return best_score.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Copy the latest published incumbent, nullptr if nothing is published yet,
+     * the copy is retried if a publish overlapped it, it never blocks a publish
+     */
+    std::shared_ptr<const Incumbent> incumbent() const
+    {
+        std::shared_ptr<Incumbent> inc = std::make_shared<Incumbent>();
+        while (true)
+        {
+            uint64_t begin = seq.load(std::memory_order_acquire);
+            if (begin & 1)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            inc->score = published_score.load(std::memory_order_relaxed);
+            const RowBuffer *buf = buffer.load(std::memory_order_acquire);
+            size_t n = buf ? std::min(num_rows.load(std::memory_order_relaxed), buf->capacity) : 0;
+            inc->solution.resize(n);
+            for (size_t r = 0; r < n; ++r)
+            {
+                const monte_utils::Assignment &row = buf->rows[r];
+                inc->solution[r].task_id = __atomic_load_n(&row.task_id, __ATOMIC_RELAXED);
+                inc->solution[r].expert_id = __atomic_load_n(&row.expert_id, __ATOMIC_RELAXED);
+                inc->solution[r].tm = __atomic_load_n(&row.tm, __ATOMIC_RELAXED);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == begin)
+                return inc->score == -HUGE_VAL ? nullptr : inc;
+        }
+    }
+
+    /**
+     * Offer a solution with `score`, `make_solution()` is only called if the score beats the best one,
+     * so a losing offer does not build its solution
+     * @return true if the offer became the best one
+     */
+    template <typename MakeSolution>
+    bool offer(double score, MakeSolution make_solution)
+    {
+        double curr = best_score.load(std::memory_order_acquire);
+        while (score > curr && !best_score.compare_exchange_weak(curr, score, std::memory_order_acq_rel))
+            ;
+        if (score <= curr)
+            return false;
+        Incumbent mine{score, make_solution()};
+        if (!publish(mine))
+            return false;
+        if (on_improve)
+            on_improve(mine);
+        write();
+        return true;
+    }
+
+    /**
+     * Take a solution found elsewhere, e.g. by another process, as the best one if it beats the best score,
+     * neither `on_improve` nor the writer is called for it, since it is already kept by whoever found it
+     * @return true if the solution became the best one
+     */
+    bool adopt(const Incumbent &inc)
+    {
+        double curr = best_score.load(std::memory_order_acquire);
+        while (inc.score > curr && !best_score.compare_exchange_weak(curr, inc.score, std::memory_order_acq_rel))
+            ;
+        if (inc.score <= curr || !publish(inc))
+            return false;
+        while (writing.test_and_set(std::memory_order_acquire))
+            std::this_thread::yield();
+        written_score = std::max(written_score, inc.score);
+        writing.clear(std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Publish `mine` unless a better incumbent racing with it is published first, which must not be replaced.
+     * Publishers take turns by the seqlock, only improving offers get here. The rows are copied into the current
+     * buffer, a larger one replaces it if the solution does not fit
+     */
+    bool publish(const Incumbent &mine)
+    {
+        uint64_t begin = seq.load(std::memory_order_relaxed);
+        while ((begin & 1) || !seq.compare_exchange_weak(begin, begin + 1, std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+            begin = seq.load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        bool better = mine.score > published_score.load(std::memory_order_relaxed);
+        if (better)
+        {
+            const RowBuffer *buf = buffer.load(std::memory_order_relaxed);
+            if (buf == nullptr || buf->capacity < mine.solution.size())
+            {
+                size_t capacity = std::max(mine.solution.size(), buf ? buf->capacity * 2 : 0);
+                buffers.emplace_back(new RowBuffer{capacity, std::unique_ptr<monte_utils::Assignment[]>(new monte_utils::Assignment[capacity])});
+                buf = buffers.back().get();
+                buffer.store(buf, std::memory_order_release);
+            }
+            for (size_t r = 0; r < mine.solution.size(); ++r)
+            {
+                monte_utils::Assignment &row = buf->rows[r];
+                __atomic_store_n(&row.task_id, mine.solution[r].task_id, __ATOMIC_RELAXED);
+                __atomic_store_n(&row.expert_id, mine.solution[r].expert_id, __ATOMIC_RELAXED);
+                __atomic_store_n(&row.tm, mine.solution[r].tm, __ATOMIC_RELAXED);
+            }
+            num_rows.store(mine.solution.size(), std::memory_order_relaxed);
+            published_score.store(mine.score, std::memory_order_relaxed);
+        }
+        seq.store(begin + 2, std::memory_order_release);
+        return better;
+    }
+
+    /**
+     * Write the incumbent if it is not written yet and the last write is not within `write_interval`,
+     * it is skipped if another thread is writing, the skipped incumbent is written by a later call or `flush`
+     */
+    void write()
+    {
+        if (!writer || writing.test_and_set(std::memory_order_acquire))
+            return;
+        write_locked(false);
+        writing.clear(std::memory_order_release);
+    }
+
+    /**
+     * Write the incumbent if it is not written yet, waiting for the writing thread if any
+     */
+    void flush()
+    {
+        if (!writer)
+            return;
+        while (writing.test_and_set(std::memory_order_acquire))
+            std::this_thread::yield();
+        write_locked(true);
+        writing.clear(std::memory_order_release);
+    }
+
+    void write_locked(bool force)
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (published_score.load(std::memory_order_acquire) <= written_score || !(force || now - last_write >= write_interval))
+            return;
+        std::shared_ptr<const Incumbent> inc = incumbent();
+        if (inc && inc->score > written_score)
+        {
+            writer(*inc);
+            written_score = inc->score;
+            last_write = now;
+        }
+    }
+};
+
+} // namespace best_board
@@ -0,0 +1,580 @@
+/**
+ * This file contains GA method
+ * Each solution contains all tasks actions, each task's action is
+ *  represented as a array with 5 integers. In the array, the value
+ *  represented the index of the expert, -1 represent no expert assigned.
+ */
+
+#pragma once
+#include "best_board.hpp"
+#include "logger.hpp"
+#include "monte_metrics.hpp"
+#include "monte_utils.hpp"
+#include "profiler.hpp"
+#include "rand_utils.hpp"
+#include "result_writer.hpp"
+#include "shm_board.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <set>
+#include <tuple>
+#include <unistd.h>
+
+namespace ga
+{
+
+static rand_utils::Xoshiro256 rng; // seeded by the master seed in main, only drawn from the main thread
+static const int NUM_INIT_SOLUTIONS = 253; // the initial generated ga solutions
+static const int NUM_MUTATIONS = 200;
+static const double MUTATION_RATIO = 0.4; // the ratio of the tasks that actions will be changed
+static const int NUM_ITERS = 10000;
+static const int SOLUTION_ELE_LEN = monte_utils::TASK_MAX_MIGRATION + 2; // waitting time, priority and migrations
+static const double SAVE_INTERVAL = 10; // seconds between two saves of the improving best result
+
+/**
+ * save result into csv file, the file is written by the background writer
+ */
+void save_result(std::vector<monte_utils::Assignment> result)
+{
+    time_t date = time(nullptr);
+    tm *date_tm = localtime(&date);
+    char result_tm_stamp[50];
+    sprintf(result_tm_stamp, "%02d%02d%02d_%02d%02d%02d.csv", date_tm->tm_year + 1900 - 2000,
+            date_tm->tm_mon + 1, date_tm->tm_mday, date_tm->tm_hour, date_tm->tm_min, date_tm->tm_sec);
+    char prefix[100] = "\0";
+    strncpy(prefix, monte_utils::PRED_RESULT_PREFIX, sizeof(monte_utils::PRED_RESULT_PREFIX));
+    result_writer::global_writer().submit(strcat(prefix, result_tm_stamp), std::move(result));
+}
+
+/**
+ * Group experts by good at processing types, one expert may belong to multiple group
+ */
+std::vector<std::vector<int>> group_experts(const std::vector<monte_utils::Expert> &experts, const int num_types)
+{
+    PROFILE_SCOPE(profiler::GROUP_EXPERTS);
+    std::vector<std::vector<int>> expt_groups(num_types);
+    for (int i = 0; i < experts.size(); ++i)
+    {
+        for (int j = 0; j < num_types; ++j)
+        {
+            if (experts[i].process_type_duras[j] < monte_utils::EXPERT_NOT_GOOD_TIME)
+                expt_groups[j].push_back(i);
+        }
+    }
+    for (int i = 0; i < expt_groups.size(); ++i)
+    {
+        std::sort(expt_groups[i].begin(), expt_groups[i].end(), [&experts, i](const int a, const int b) -> bool {
+            if (experts[a].process_type_duras[i] != experts[b].process_type_duras[i])
+                return experts[a].process_type_duras[i] < experts[b].process_type_duras[i];
+            else
+                return experts[a].expert_id < experts[b].expert_id;
+        });
+    }
+    return expt_groups;
+}
+
+/**
+ * Initial generate solutions for GA
+ * each solution is an array with size num tasks * 5
+ * for each task, there are 5 integers, such as [a,b,-1,-1,3,4,12] which means
+ * that the task migrate via expert index with 3,4 and 12, and the first two values, a is the waitting time
+ * at the very beginning and b is the priority value.
+ * what shoule be empahsised is that the last expert should good at processing
+ * the task and all previous experts all should be not good at processing the task
+ */
+std::vector<std::vector<int>> ga_init_solutions(std::vector<monte_utils::Task> &tasks,
+                                                std::vector<std::vector<int>> &expt_groups)
+{
+    // the solution struct each task add two attribute: waitting time at beginning and priority number
+    std::vector<std::vector<int>> solutions(NUM_INIT_SOLUTIONS, std::vector<int>(SOLUTION_ELE_LEN * tasks.size(), -1));
+    for (int i = 0; i < NUM_INIT_SOLUTIONS; ++i)
+    {
+        for (int j = 0; j < tasks.size(); ++j)
+        {
+            // random generate waitting time at beginning stage and the priority number
+            solutions[i][j * SOLUTION_ELE_LEN] = rand_utils::range(rng, 0, (int)(tasks[i].max_resp * 0.8));
+            solutions[i][j * SOLUTION_ELE_LEN + 1] = rand_utils::range(rng, 0, (int)tasks.size());
+            int start_pos = rand_utils::range(rng, j * SOLUTION_ELE_LEN + 2, (j + 1) * SOLUTION_ELE_LEN - 1);
+            int prev_expert_idx = -1;
+            while (start_pos < (j + 1) * SOLUTION_ELE_LEN - 1)
+            {
+                // set not suitable experts idx
+                int rand_group = rand_utils::range(rng, 0, expt_groups.size() - 1);
+                int expert_idx = expt_groups[rand_group][rand_utils::range(rng, 0, expt_groups[rand_group].size() - 1)];
+                // make sure that the consecutive two experts are not same
+                while (expert_idx == prev_expert_idx)
+                {
+                    rand_group = rand_utils::range(rng, 0, expt_groups.size() - 1);
+                    expert_idx = expt_groups[rand_group][rand_utils::range(rng, 0, expt_groups[rand_group].size() - 1)];
+                }
+                prev_expert_idx = expert_idx;
+                solutions[i][start_pos] = expert_idx;
+                start_pos++;
+            }
+            // the last expert must be suitable
+            int group_idx = tasks[j].type;
+            solutions[i][start_pos] = expt_groups[group_idx][rand_utils::range(rng, 0, expt_groups[group_idx].size() - 1)];
+        }
+    }
+    return solutions;
+}
+
+/**
+ * The crossover operation of two solution
+ */
+std::vector<int> crossover(std::vector<int> &s1, std::vector<int> &s2)
+{
+    std::vector<int> s_n = std::vector<int>(s1.size(), -1);
+    for (int i = 0; i < s1.size(); i += 2 * SOLUTION_ELE_LEN)
+    {
+        for (int j = i; j < i + SOLUTION_ELE_LEN; ++j)
+            s_n[j] = s1[j];
+    }
+    for (int i = SOLUTION_ELE_LEN; i < s2.size(); i += 2 * SOLUTION_ELE_LEN)
+    {
+        for (int j = i; j < i + SOLUTION_ELE_LEN; ++j)
+            s_n[j] = s2[j];
+    }
+    return s_n;
+}
+
+/**
+ * The actions for part of the tasks will be changed
+ */
+void mutation(std::vector<int> &s, std::vector<monte_utils::Task> &tasks, std::vector<std::vector<int>> &expt_groups)
+{
+    std::set<int> mut_idxs;
+    int task_count = (int)s.size() / SOLUTION_ELE_LEN;
+    int mut_count = (int)(MUTATION_RATIO * task_count);
+    while (mut_idxs.size() < mut_count)
+        mut_idxs.insert(rand_utils::range(rng, 0, task_count - 1));
+    // mutate
+    for (const int &idx : mut_idxs)
+    {
+        s[idx * SOLUTION_ELE_LEN] = rand_utils::range(rng, 0, (int)(tasks[idx].max_resp * 0.8));
+        s[idx * SOLUTION_ELE_LEN + 1] = rand_utils::range(rng, 0, (int)tasks.size());
+        int start_pos = idx * SOLUTION_ELE_LEN + 2;
+        start_pos = rand_utils::range(rng, start_pos, (idx + 1) * SOLUTION_ELE_LEN - 1);
+        for (int i = idx * SOLUTION_ELE_LEN + 2; i < start_pos; ++i)
+            s[i] = -1;
+        int prev_expert_idx = -1;
+        while (start_pos < (idx + 1) * SOLUTION_ELE_LEN - 1)
+        {
+            // set not suitable experts idx
+            int rand_group = rand_utils::range(rng, 0, expt_groups.size() - 1);
+            int curr_expert_idx = expt_groups[rand_group][rand_utils::range(rng, 0, expt_groups[rand_group].size() - 1)];
+            while (curr_expert_idx == prev_expert_idx)
+            {
+                rand_group = rand_utils::range(rng, 0, expt_groups.size() - 1);
+                curr_expert_idx = expt_groups[rand_group][rand_utils::range(rng, 0, expt_groups[rand_group].size() - 1)];
+            }
+            prev_expert_idx = curr_expert_idx;
+            s[start_pos] = curr_expert_idx;
+            start_pos++;
+        }
+        // last expert must be suitable
+        s[start_pos] = expt_groups[tasks[idx].type][rand_utils::range(rng, 0, expt_groups[tasks[idx].type].size() - 1)];
+    }
+}
+
+/**
+ * Extract result, each row is task id, expert id and time
+ */
+std::vector<monte_utils::Assignment> extract_result(std::vector<monte_utils::Task> &tasks, std::vector<monte_utils::Expert> &experts)
+{
+    std::vector<monte_utils::Assignment> result;
+    result.reserve(tasks.size());
+    for (int i = 0; i < tasks.size(); ++i)
+    {
+        for (int j = 0; j < tasks[i].curr_migrate_count; ++j)
+        {
+            result.push_back({tasks[i].task_id, experts[tasks[i].each_stay_expert_id[j]].expert_id, tasks[i].assign_tm[j]});
+        }
+    }
+    return result;
+}
+
+/**
+ * Scratch of `convert_solution_to_result`, kept by each thread of the pool and reused across decodes
+ */
+struct Decoder
+{
+    // idle channels of each expert at each time slot, only as long as the latest time slot marked so far,
+    // later time slots are all idle
+    std::vector<std::vector<int>> expert_marker;
+    std::vector<int> task_idxs;
+
+    void reset(int num_experts)
+    {
+        expert_marker.resize(num_experts);
+        for (std::vector<int> &marker : expert_marker)
+            std::fill(marker.begin(), marker.end(), monte_utils::EXPERT_MAX_PARALLEL);
+    }
+
+    /**
+     * Take a channel of the expert in [low, high), the marker grows to cover the interval
+     */
+    void take(int expt_idx, int low, int high)
+    {
+        std::vector<int> &marker = expert_marker[expt_idx];
+        if (marker.size() < (size_t)high)
+            marker.resize(std::max((size_t)high, marker.size() * 2), monte_utils::EXPERT_MAX_PARALLEL);
+        for (int k = low; k < high; ++k)
+            marker[k] -= 1;
+    }
+
+    /**
+     * If the expert has an idle channel at each time slot of [low, high)
+     */
+    bool idle(int expt_idx, int low, int high) const
+    {
+        const std::vector<int> &marker = expert_marker[expt_idx];
+        for (int k = low; k < std::min(high, (int)marker.size()); ++k)
+        {
+            if (marker[k] <= 0)
+                return false;
+        }
+        return true;
+    }
+};
+
+/**
+ * convert solution into result
+ * The function will simulate according to the solution, tasks and experts's record variables will be changed
+ * the result is formed with array of [task id , expert id, time]
+ * @return the tuple of result format and score
+ */
+std::tuple<std::vector<monte_utils::Assignment>, double> convert_solution_to_result(std::vector<int> &s,
+                                                                                    std::vector<monte_utils::Task> tasks,
+                                                                                    std::vector<monte_utils::Expert> experts,
+                                                                                    Decoder &decoder)
+{
+    PROFILE_SCOPE(profiler::GA_DECODE);
+    decoder.reset(experts.size());
+    std::vector<int> &task_idxs = decoder.task_idxs;
+    task_idxs.resize(tasks.size());
+    for (int i = 0; i < tasks.size(); ++i)
+        task_idxs[i] = i;
+    std::sort(task_idxs.begin(), task_idxs.end(), [&s, &tasks](const int a, const int b) -> bool {
+        if (tasks[a].generate_tm != tasks[b].generate_tm)
+            return tasks[a].generate_tm < tasks[b].generate_tm;
+        else if (s[a * SOLUTION_ELE_LEN + 1] != s[b * SOLUTION_ELE_LEN + 1])
+            return s[a * SOLUTION_ELE_LEN + 1] < s[b * SOLUTION_ELE_LEN + 1];
+        else
+            return a < b;
+    });
+    int process_count = 0;
+    for (int i : task_idxs)
+    {
+        int start_pos = i * SOLUTION_ELE_LEN + 2, base = i * SOLUTION_ELE_LEN + 2;
+        while (s[start_pos] == -1)
+            start_pos++;
+        tasks[i].curr_migrate_count = SOLUTION_ELE_LEN - 2 - (start_pos - base); // the total migration count
+        for (int j = 0; j < tasks[i].curr_migrate_count; ++j)
+        {
+            tasks[i].each_stay_expert_id[j] = s[start_pos + j];
+            tasks[i].assign_tm[j] = tasks[i].generate_tm + j + s[i * SOLUTION_ELE_LEN];
+        }
+        std::vector<int> process_times(tasks[i].curr_migrate_count);
+        int task_type = tasks[i].type;
+        for (int j = 0; j < tasks[i].curr_migrate_count; ++j)
+            process_times[j] = experts[tasks[i].each_stay_expert_id[j]].process_type_duras[task_type];
+        int migrate_count = tasks[i].curr_migrate_count;
+        // check valid intervals
+        bool flag = false;
+        while (!flag)
+        {
+            flag = true;
+            std::vector<int> start_times(migrate_count + 1, 0);
+            for (int j = 0; j < migrate_count; ++j)
+                start_times[j] = tasks[i].assign_tm[j];
+            start_times[migrate_count] = start_times[migrate_count - 1] + process_times[migrate_count - 1];
+            for (int j = 0; j < migrate_count; ++j)
+            {
+                if (!decoder.idle(tasks[i].each_stay_expert_id[j], start_times[j], start_times[j + 1]))
+                {
+                    flag = false;
+                    tasks[i].assign_tm[j]++;
+                    for (int k = j + 1; k < tasks[i].curr_migrate_count; ++k)
+                        tasks[i].assign_tm[k] = std::max(tasks[i].assign_tm[k - 1] + 1, tasks[i].assign_tm[k]);
+                    break;
+                }
+            }
+        }
+        // fill time intervales
+        // the tasks may finish at intermediate expert, need to check
+        std::vector<int> start_times(migrate_count + 1, 0);
+        for (int j = 0; j < migrate_count; ++j)
+            start_times[j] = tasks[i].assign_tm[j];
+        start_times[migrate_count] = start_times[migrate_count - 1] + process_times[migrate_count - 1];
+        tasks[i].start_process_tm = start_times[0];
+        tasks[i].finish_tm = start_times[migrate_count];
+        for (int j = 0; j < migrate_count; ++j)
+        {
+            if (j < migrate_count - 1 && start_times[j + 1] - start_times[j] >= process_times[j])
+            {
+                // task finish on the expert
+                std::fill(tasks[i].each_stay_expert_id + j + 1, tasks[i].each_stay_expert_id + migrate_count, -1);
+                std::fill(tasks[i].assign_tm + j + 1, tasks[i].assign_tm + migrate_count, -1);
+                tasks[i].curr_migrate_count = j + 1;
+                decoder.take(tasks[i].each_stay_expert_id[j], start_times[j], start_times[j] + process_times[j]);
+                break;
+            }
+            else
+            {
+                decoder.take(tasks[i].each_stay_expert_id[j], start_times[j], start_times[j + 1]);
+            }
+        }
+    }
+    // update experts
+    for (int i = 0; i < experts.size(); ++i)
+    {
+        for (int idle : decoder.expert_marker[i])
+        {
+            if (idle < monte_utils::EXPERT_MAX_PARALLEL)
+                experts[i].busy_sum++;
+        }
+    }
+    std::vector<monte_utils::Assignment> result = extract_result(tasks, experts);
+    double score = monte_metrics::score(tasks, experts);
+    return std::make_tuple(std::move(result), score);
+}
+
+/**
+ * assign a task to expert
+ */
+void assign_task(monte_utils::Task &task, monte_utils::Expert &expert, int task_idx, int expt_idx, int env_tm)
+{
+    if (task.start_process_tm == -1)
+        task.start_process_tm = env_tm;
+    task.each_stay_expert_id[task.curr_migrate_count] = expt_idx;
+    task.assign_tm[task.curr_migrate_count] = env_tm;
+    task.curr_migrate_count++;
+
+    for (int i = 0; i < monte_utils::EXPERT_MAX_PARALLEL; ++i)
+    {
+        if (expert.channels[i] == -1)
+        {
+            expert.channels[i] = task_idx;
+            expert.take_channel(env_tm);
+            break;
+        }
+    }
+}
+
+/**
+ * release task from expert
+ */
+void release_task(monte_utils::Expert &expert, int task_idx, int env_tm)
+{
+    for (int i = 0; i < monte_utils::EXPERT_MAX_PARALLEL; ++i)
+    {
+        if (expert.channels[i] == task_idx)
+        {
+            expert.channels[i] = -1;
+            expert.free_channel(env_tm);
+            break;
+        }
+    }
+}
+
+/**
+ * Generate benchmark solution for a fine start point of ga method
+ */
+std::vector<int> benchmark_solution_gen(std::vector<monte_utils::Task> tasks,
+                                        std::vector<monte_utils::Expert> experts, std::vector<std::vector<int>> &expt_groups)
+{
+    std::vector<int> bm_solution(SOLUTION_ELE_LEN * tasks.size(), -1);
+    std::vector<std::vector<int>> task_groups(expt_groups.size());
+    for (int i = 0; i < tasks.size(); ++i)
+        task_groups[tasks[i].type].push_back(i);
+    std::vector<int> task_grp_progress(task_groups.size(), 0);
+    int env_tm = 0, num_left = tasks.size(), priority_num = 0;
+    while (num_left > 0)
+    {
+        for (int i = 0; i < task_groups.size(); ++i)
+        {
+            if (task_grp_progress[i] < task_groups[i].size())
+            {
+                int task_idx = task_groups[i][task_grp_progress[i]];
+                if (tasks[task_idx].generate_tm > env_tm)
+                    continue;
+                int task_type = tasks[task_idx].type;
+                std::sort(expt_groups[task_type].begin(), expt_groups[task_type].end(), [&experts, task_type, env_tm](const int a, const int b) -> bool {
+                    if (experts[a].process_type_duras[task_type] != experts[b].process_type_duras[task_type])
+                        return experts[a].process_type_duras[task_type] < experts[b].process_type_duras[task_type];
+                    else if (experts[a].busy_time(env_tm) != experts[b].busy_time(env_tm))
+                        return experts[a].busy_time(env_tm) < experts[b].busy_time(env_tm);
+                    else if (experts[a].num_idle_channel != experts[b].num_idle_channel)
+                        return experts[a].num_idle_channel > experts[b].num_idle_channel;
+                    else
+                        return experts[a].expert_id < experts[b].expert_id;
+                });
+                for (int expt_idx : expt_groups[task_type])
+                {
+                    if (experts[expt_idx].num_idle_channel > 0)
+                    {
+                        assign_task(tasks[task_idx], experts[expt_idx], task_idx, expt_idx, env_tm);
+                        bm_solution[task_idx * SOLUTION_ELE_LEN] = env_tm - tasks[task_idx].generate_tm; // set waitting time at beginning
+                        bm_solution[task_idx * SOLUTION_ELE_LEN + 1] = priority_num++;
+                        task_grp_progress[i]++;
+                        break;
+                    }
+                }
+            }
+        }
+
+        // check finish, the expert is still busy during the finishing slot
+        for (int i = 0; i < experts.size(); ++i)
+        {
+            for (int j = 0; j < monte_utils::EXPERT_MAX_PARALLEL; ++j)
+            {
+                if (experts[i].channels[j] == -1)
+                    continue;
+                int task_idx = experts[i].channels[j];
+                int process_tm = experts[i].process_type_duras[tasks[task_idx].type],
+                    pre_assign_tm = tasks[task_idx].assign_tm[tasks[task_idx].curr_migrate_count - 1];
+                if (pre_assign_tm + process_tm <= env_tm)
+                {
+                    release_task(experts[i], task_idx, env_tm + 1);
+                    tasks[task_idx].finish_tm = env_tm;
+                    num_left--;
+                }
+            }
+        }
+        env_tm++;
+    }
+
+    save_result(extract_result(tasks, experts));
+    double bm_score = monte_metrics::score(tasks, experts);
+    LOG_INFO("bm score=%lf", bm_score);
+    // eatract as ga method format solution
+    for (int i = 0; i < tasks.size(); ++i)
+        bm_solution[(i + 1) * SOLUTION_ELE_LEN - 1] = tasks[i].each_stay_expert_id[0];
+    return bm_solution;
+}
+
+/**
+ * Encode a result found by any method as a ga solution for warm start,
+ * the waiting time and priority are taken from the first assignment of each task and its stays are kept in order.
+ * The solution is decoded with one time slot between migrations, so it is a start point near the result, not the same schedule
+ */
+std::vector<int> solution_from_result(const std::vector<monte_utils::Assignment> &result, std::vector<monte_utils::Task> &tasks,
+                                      std::vector<monte_utils::Expert> &experts, std::vector<std::vector<int>> &expt_groups)
+{
+    std::map<int, int> task_idxs, expert_idxs;
+    for (int i = 0; i < tasks.size(); ++i)
+        task_idxs[tasks[i].task_id] = i;
+    for (int i = 0; i < experts.size(); ++i)
+        expert_idxs[experts[i].expert_id] = i;
+    std::vector<monte_utils::Assignment> rows(result);
+    monte_utils::sort_assignments(rows);
+    std::vector<std::vector<int>> stays(tasks.size());
+    std::vector<int> first_tm(tasks.size(), -1);
+    int priority = 0;
+    std::vector<int> s(SOLUTION_ELE_LEN * tasks.size(), -1);
+    for (const monte_utils::Assignment &row : rows)
+    {
+        if (!task_idxs.count(row.task_id) || !expert_idxs.count(row.expert_id))
+            continue;
+        int idx = task_idxs[row.task_id];
+        if (first_tm[idx] == -1)
+        {
+            first_tm[idx] = row.tm;
+            s[idx * SOLUTION_ELE_LEN] = std::max(row.tm - tasks[idx].generate_tm, 0);
+            s[idx * SOLUTION_ELE_LEN + 1] = priority++;
+        }
+        if (stays[idx].size() < monte_utils::TASK_MAX_MIGRATION)
+            stays[idx].push_back(expert_idxs[row.expert_id]);
+    }
+    for (int i = 0; i < tasks.size(); ++i)
+    {
+        if (first_tm[i] == -1)
+        {
+            s[i * SOLUTION_ELE_LEN] = 0;
+            s[i * SOLUTION_ELE_LEN + 1] = priority++;
+        }
+        // the last expert must be suitable
+        if (stays[i].empty() || experts[stays[i].back()].process_type_duras[tasks[i].type] == monte_utils::EXPERT_NOT_GOOD_TIME)
+            stays[i].push_back(expt_groups[tasks[i].type][0]);
+        if (stays[i].size() > monte_utils::TASK_MAX_MIGRATION)
+            stays[i].erase(stays[i].begin());
+        std::copy(stays[i].begin(), stays[i].end(), s.begin() + (i + 1) * SOLUTION_ELE_LEN - stays[i].size());
+    }
+    return s;
+}
+
+/**
+ * Run GA algorithm
+ * With a shared memory board, the incumbent of other processes joins the population when it beats the best score of this run
+ */
+std::vector<monte_utils::Assignment> ga_run(std::vector<monte_utils::Task> &tasks,
+                                            std::vector<monte_utils::Expert> &experts, std::vector<std::vector<int>> &expt_groups)
+{
+    LOG_INFO("Initial solutions...");
+    std::vector<std::vector<int>> solutions = ga_init_solutions(tasks, expt_groups);
+    solutions.emplace_back(benchmark_solution_gen(tasks, experts, expt_groups));
+    best_board::BestBoard board([](const best_board::Incumbent &inc) { shm_board::global_board().push(inc.score, inc.solution); },
+                                [](const best_board::Incumbent &inc) { save_result(inc.solution); },
+                                SAVE_INTERVAL);
+    // each thread of the pool decodes with its own scratch
+    thread_pool::ThreadPool &pool = thread_pool::global_pool();
+    std::vector<Decoder> decoders(pool.size() + 1);
+    LOG_INFO("Start GA method....");
+    for (int iter = 1; iter <= NUM_ITERS; ++iter)
+    {
+        std::shared_ptr<best_board::Incumbent> shared = shm_board::global_board().sync(board);
+        if (shared)
+        {
+            LOG_INFO("\tadd shared incumbent, score=%lf", shared->score);
+            solutions.emplace_back(solution_from_result(shared->solution, tasks, experts, expt_groups));
+        }
+        std::vector<std::tuple<std::vector<monte_utils::Assignment>, double>> result_scores;
+        LOG_DEBUG("Iter #%05d: start simulations for solutions...", iter);
+        result_scores.resize(solutions.size());
+        pool.parallel_for(solutions.size(), [&](const int i) {
+            result_scores[i] = convert_solution_to_result(solutions[i], tasks, experts, decoders[pool.slot()]);
+            board.offer(std::get<1>(result_scores[i]), [&]() { return std::move(std::get<0>(result_scores[i])); });
+        });
+        LOG_DEBUG("\tsolutions simulate finish..");
+        double max_score = 0, min_score = 1e8;
+        int max_score_idx = 0, min_score_idx = 0;
+        for (int i = 0; i < result_scores.size(); ++i)
+        {
+            if (std::get<1>(result_scores[i]) > max_score)
+            {
+                max_score = std::get<1>(result_scores[i]);
+                max_score_idx = i;
+            }
+            if (std::get<1>(result_scores[i]) < min_score)
+            {
+                min_score = std::get<1>(result_scores[i]);
+                min_score_idx = i;
+            }
+        }
+        int s2 = rand_utils::range(rng, 0, result_scores.size() - 1);
+        while (s2 == max_score_idx || s2 == min_score_idx)
+            s2 = rand_utils::range(rng, 0, result_scores.size() - 1);
+        // crossover
+        std::vector<int> s_nw = crossover(solutions[max_score_idx], solutions[s2]);
+        solutions.emplace_back(s_nw);
+        // mutations
+        for (int i = 0; i < NUM_MUTATIONS; ++i)
+        {
+            int idx = rand_utils::range(rng, 0, solutions.size() - 1);
+            while (idx == max_score_idx)
+                idx = rand_utils::range(rng, 0, solutions.size() - 1);
+            mutation(solutions[idx], tasks, expt_groups);
+        }
+        solutions.erase(solutions.begin() + min_score_idx);
+        LOG_INFO("Iter #%05d: best score=%lf, min score=%lf", iter, max_score, min_score);
+    }
+    board.flush();
+    std::shared_ptr<const best_board::Incumbent> best = board.incumbent();
+    return best ? best->solution : std::vector<monte_utils::Assignment>();
+}
+
+} // namespace ga
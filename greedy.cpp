@@ -1,38 +1,101 @@
 /**
  * This file contains method of greedly dispatch tasks
  */
+#include "best_board.hpp"
 #include "monte_metrics.hpp"
 #include "monte_utils.hpp"
-#include "utils.hpp"
+#include "profiler.hpp"
+#include "rand_utils.hpp"
+#include "result_writer.hpp"
+#include "shm_board.hpp"
+#include "thread_pool.hpp"
 #include <ctime>
-#include <omp.h>
+#include <iostream>
+#include <memory>
 #include <set>
 #include <tuple>
 
 static double EPSILON = 0.9;
+static const double SAVE_INTERVAL = 10; // seconds between two saves of the improving best result
+
+/**
+ * Snapshots taken during one run share a chain, the chain keeps the state at the beginning of the run as base,
+ * and for each snapshot only the tasks and experts changed since the previous snapshot of the run
+ */
+struct SnapShotChain
+{
+    struct Delta
+    {
+        std::vector<std::pair<int, monte_utils::Task>> tasks;
+        std::vector<std::pair<int, monte_utils::Expert>> experts;
+        std::vector<int> finish_idxs;
+    };
+
+    std::vector<monte_utils::Task> base_tasks;
+    std::vector<monte_utils::Expert> base_experts;
+    std::vector<bool> base_flags_finish;
+    std::vector<Delta> deltas;
+
+    SnapShotChain(const std::vector<monte_utils::Task> &tasks, const std::vector<monte_utils::Expert> &experts,
+                  const std::vector<bool> &flags_finish) : base_tasks(tasks), base_experts(experts), base_flags_finish(flags_finish) {}
+};
+
+/**
+ * Indexes of tasks or experts changed since the previous snapshot
+ */
+struct DirtyIdxs
+{
+    std::vector<int> idxs;
+    std::vector<bool> flags;
+
+    DirtyIdxs(int n) : flags(n, false) {}
+
+    void mark(int i)
+    {
+        if (!flags[i])
+        {
+            flags[i] = true;
+            idxs.push_back(i);
+        }
+    }
+
+    void clear()
+    {
+        for (int i : idxs)
+            flags[i] = false;
+        idxs.clear();
+    }
+};
 
 struct SnapShot
 {
-    std::vector<monte_utils::Task> tasks;
-    std::vector<monte_utils::Expert> experts;
-    std::vector<bool> flags_finish;
+    std::shared_ptr<SnapShotChain> chain;
+    int chain_pos; // the snapshot state is the chain base with deltas [0, chain_pos] applied
     int snap_shot_tm;
     int score; // the score of the scheme which the snapshot belongs to
 
-    SnapShot() : snap_shot_tm(0), score(0) {}
-    SnapShot(int _snap_shot_tm, std::vector<monte_utils::Task> _tasks, std::vector<monte_utils::Expert> _experts, std::vector<bool> _flag_finish)
+    SnapShot() : chain_pos(-1), snap_shot_tm(0), score(0) {}
+    SnapShot(int _snap_shot_tm, std::shared_ptr<SnapShotChain> _chain, int _chain_pos)
+        : chain(_chain), chain_pos(_chain_pos), snap_shot_tm(_snap_shot_tm), score(0) {}
+
+    /**
+     * Build the full state of the snapshot for restarting from it
+     */
+    void materialize(std::vector<monte_utils::Task> &tasks, std::vector<monte_utils::Expert> &experts, std::vector<bool> &flags_finish) const
     {
-        this->snap_shot_tm = _snap_shot_tm;
-        this->score = 0;
-        tasks.resize(_tasks.size());
-        for (int i = 0; i < tasks.size(); ++i)
-            tasks[i] = _tasks[i];
-        experts.resize(_experts.size());
-        for (int i = 0; i < experts.size(); ++i)
-            experts[i] = _experts[i];
-        flags_finish.resize(_flag_finish.size());
-        for (int i = 0; i < _flag_finish.size(); ++i)
-            flags_finish[i] = _flag_finish[i];
+        tasks = chain->base_tasks;
+        experts = chain->base_experts;
+        flags_finish = chain->base_flags_finish;
+        for (int k = 0; k <= chain_pos; ++k)
+        {
+            const SnapShotChain::Delta &delta = chain->deltas[k];
+            for (const std::pair<int, monte_utils::Task> &tsk : delta.tasks)
+                tasks[tsk.first] = tsk.second;
+            for (const std::pair<int, monte_utils::Expert> &expt : delta.experts)
+                experts[expt.first] = expt.second;
+            for (int idx : delta.finish_idxs)
+                flags_finish[idx] = true;
+        }
     }
 };
 
@@ -41,6 +104,7 @@ struct SnapShot
  */
 std::vector<std::vector<int>> group_experts(const std::vector<monte_utils::Expert> &experts, const int num_types)
 {
+    PROFILE_SCOPE(profiler::GROUP_EXPERTS);
     std::vector<std::vector<int>> expt_groups(num_types);
     for (int i = 0; i < experts.size(); ++i)
     {
@@ -63,24 +127,20 @@ std::vector<std::vector<int>> group_experts(const std::vector<monte_utils::Exper
 }
 
 /**
- * Extract result, each array in the result is [task id, expert id , time]
+ * Extract result, each row is task id, expert id and time
  */
-std::vector<std::vector<int>> extract_result(const std::vector<monte_utils::Task> &tasks, const std::vector<monte_utils::Expert> &experts)
+std::vector<monte_utils::Assignment> extract_result(const std::vector<monte_utils::Task> &tasks, const std::vector<monte_utils::Expert> &experts)
 {
-    std::vector<std::vector<int>> result;
+    std::vector<monte_utils::Assignment> result;
+    result.reserve(tasks.size());
     for (int i = 0; i < tasks.size(); ++i)
     {
         for (int j = 0; j < tasks[i].curr_migrate_count; ++j)
         {
-            result.emplace_back(std::vector<int>({tasks[i].task_id, experts[tasks[i].each_stay_expert_id[j]].expert_id, tasks[i].assign_tm[j]}));
+            result.push_back({tasks[i].task_id, experts[tasks[i].each_stay_expert_id[j]].expert_id, tasks[i].assign_tm[j]});
         }
     }
-    std::sort(result.begin(), result.end(), [](const std::vector<int> &a, const std::vector<int> &b) -> bool {
-        if (a[2] != b[2])
-            return a[2] < b[2];
-        else
-            return a[0] < b[0];
-    });
+    monte_utils::sort_assignments(result);
     return result;
 }
 
@@ -99,7 +159,7 @@ void assign_task(monte_utils::Task &task, monte_utils::Expert &expert, const int
         if (expert.channels[i] == -1)
         {
             expert.channels[i] = task_idx;
-            expert.num_idle_channel--;
+            expert.take_channel(env_tm);
             break;
         }
     }
@@ -108,14 +168,14 @@ void assign_task(monte_utils::Task &task, monte_utils::Expert &expert, const int
 /**
  * Release task from expert
  */
-void release_task(monte_utils::Expert &expert, const int task_idx)
+void release_task(monte_utils::Expert &expert, const int task_idx, const int env_tm)
 {
     for (int i = 0; i < monte_utils::EXPERT_MAX_PARALLEL; ++i)
     {
         if (expert.channels[i] == task_idx)
         {
             expert.channels[i] = -1;
-            expert.num_idle_channel++;
+            expert.free_channel(env_tm);
             break;
         }
     }
@@ -129,12 +189,29 @@ void swap_tasks(monte_utils::Task &task_a, monte_utils::Task &task_b,
                 int expert_a_idx, int expert_b_idx, int env_tm)
 {
     // release resources
-    release_task(expert_a, task_a_idx);
-    release_task(expert_b, task_b_idx);
+    release_task(expert_a, task_a_idx, env_tm);
+    release_task(expert_b, task_b_idx, env_tm);
     assign_task(task_a, expert_b, task_a_idx, expert_b_idx, env_tm);
     assign_task(task_b, expert_a, task_b_idx, expert_a_idx, env_tm);
 }
 
+/**
+ * Rotate tasks of a migration cycle, cycle[k] moves onto the expert of cycle[(k + 1) % size]
+ */
+void rotate_tasks(std::vector<monte_utils::Task> &tasks, std::vector<monte_utils::Expert> &experts, const int *cycle,
+                  const int size, const int env_tm)
+{
+    for (int k = 0; k < size; ++k)
+        release_task(experts[tasks[cycle[k]].each_stay_expert_id[tasks[cycle[k]].curr_migrate_count - 1]], cycle[k], env_tm);
+    // the expert of cycle[k + 1] is still recorded when cycle[k] moves, only the first one needs saving
+    int first_expt_idx = tasks[cycle[0]].each_stay_expert_id[tasks[cycle[0]].curr_migrate_count - 1];
+    for (int k = 0; k < size; ++k)
+    {
+        int expt_idx = k + 1 < size ? tasks[cycle[k + 1]].each_stay_expert_id[tasks[cycle[k + 1]].curr_migrate_count - 1] : first_expt_idx;
+        assign_task(tasks[cycle[k]], experts[expt_idx], cycle[k], expt_idx, env_tm);
+    }
+}
+
 /**
  * check if two task swap is valid
  */
@@ -154,19 +231,23 @@ bool swap_check(monte_utils::Task &task_i, monte_utils::Task &task_j, monte_util
  * need to be checked, must keep sure that the task must finally been executed on suitable expert
  * @param snapshot_env_tm: if use snapshot, the simulation will start from the snapshot status
  * @param use_snapshot: the flag of is start from snap shot status
+ * @param rng: random generator of this run, runs in parallel must not share it
  * @param take_snapshot_gap: the time duration between two snapshots
  * @return return the convert result format, and random snap shots list
  */
-std::tuple<std::vector<std::vector<int>>, double, std::vector<SnapShot>> run_alg(std::vector<monte_utils::Task> tasks, std::vector<monte_utils::Expert> experts,
-                                                                                 std::vector<bool> flag_fin,
-                                                                                 const std::vector<std::vector<int>> &expt_groups,
-                                                                                 const int snapshot_env_tm, bool use_snapshot, const int take_snapshot_gap = 50)
+std::tuple<std::vector<monte_utils::Assignment>, double, std::vector<SnapShot>> run_alg(std::vector<monte_utils::Task> tasks, std::vector<monte_utils::Expert> experts,
+                                                                                        std::vector<bool> flag_fin,
+                                                                                        const std::vector<std::vector<int>> &expt_groups,
+                                                                                        const int snapshot_env_tm, bool use_snapshot, rand_utils::Xoshiro256 &rng,
+                                                                                        const int take_snapshot_gap = 50)
 {
     int env_tm = 0, num_finish = 0;
     if (use_snapshot)
         env_tm = snapshot_env_tm;
     std::vector<SnapShot> snapshots;
-    int snap_shot_beg = (int)((double)rand() / RAND_MAX * 200); // random choose snapshot start time
+    std::shared_ptr<SnapShotChain> chain;
+    DirtyIdxs dirty_tasks(tasks.size()), dirty_experts(experts.size());
+    int snap_shot_beg = rand_utils::below(rng, 200); // random choose snapshot start time
     std::vector<bool> flags_finish;
     if (use_snapshot)
     {
@@ -179,10 +260,17 @@ std::tuple<std::vector<std::vector<int>>, double, std::vector<SnapShot>> run_alg
     {
         flags_finish = std::vector<bool>(tasks.size(), false);
     }
+    chain = std::make_shared<SnapShotChain>(tasks, experts, flags_finish);
+    monte_utils::MisplacedTasks misplaced;
+    misplaced.init(tasks, experts, expt_groups.size());
+    monte_utils::EpochFlags flags_vis(tasks.size()); // tasks operated at current tick
     while (num_finish < tasks.size())
     {
-        std::vector<bool> flags_vis(tasks.size(), false);
+        PROFILE_COUNT(profiler::TICKS, 1);
+        PROFILE_LAPS(laps);
+        flags_vis.clear();
         // check if tasks finish
+        PROFILE_LAP(laps, profiler::FINISH_CHECK);
         for (int i = 0; i < tasks.size(); ++i)
         {
             if (!(flags_finish[i] || tasks[i].curr_migrate_count == 0))
@@ -195,13 +283,15 @@ std::tuple<std::vector<std::vector<int>>, double, std::vector<SnapShot>> run_alg
                     tasks[i].finish_tm = env_tm;
                     // release expert resource
                     int expt_idx = tasks[i].each_stay_expert_id[tasks[i].curr_migrate_count - 1];
-                    release_task(experts[expt_idx], i);
-                    flags_vis[i] = true;
+                    release_task(experts[expt_idx], i, env_tm);
+                    misplaced.update(tasks, experts, i);
+                    flags_vis.set(i);
                 }
             }
         }
 
         // check if have generated tasks
+        PROFILE_LAP(laps, profiler::ASSIGN);
         for (int i = 0; i < tasks.size(); ++i)
         {
             if (tasks[i].generate_tm > env_tm || tasks[i].curr_migrate_count > 0)
@@ -210,12 +300,11 @@ std::tuple<std::vector<std::vector<int>>, double, std::vector<SnapShot>> run_alg
             for (int j = 0; j < expt_groups[tasks[i].type].size() && !flag_suc; ++j)
             {
                 int expt_idx = expt_groups[tasks[i].type][j];
-                double rand_num = (double)rand() / RAND_MAX;
-                if (experts[expt_idx].num_idle_channel > 0 && rand_num < EPSILON)
+                if (experts[expt_idx].num_idle_channel > 0 && rand_utils::bernoulli(rng, EPSILON))
                 {
                     flag_suc = true;
                     assign_task(tasks[i], experts[expt_idx], i, expt_idx, env_tm);
-                    flags_vis[i] = true;
+                    flags_vis.set(i);
                     break;
                 }
             }
@@ -224,12 +313,12 @@ std::tuple<std::vector<std::vector<int>>, double, std::vector<SnapShot>> run_alg
                 // can only assign to not suitable expert
                 for (int j = 0; j < experts.size() && !flag_suc; ++j)
                 {
-                    double rand_num = (double)rand() / RAND_MAX;
-                    if (experts[j].num_idle_channel > 0 && rand_num < EPSILON)
+                    if (experts[j].num_idle_channel > 0 && rand_utils::bernoulli(rng, EPSILON))
                     {
                         flag_suc = true;
                         assign_task(tasks[i], experts[j], i, j, env_tm);
-                        flags_vis[i] = true;
+                        misplaced.update(tasks, experts, i);
+                        flags_vis.set(i);
                     }
                 }
             }
@@ -239,6 +328,7 @@ std::tuple<std::vector<std::vector<int>>, double, std::vector<SnapShot>> run_alg
         // and must keep sure task finally exected on suitable expert
         // firstly check if suitable experts available, then check if swap can be taken to make
         // some tasks been executed on suitable experts
+        PROFILE_LAP(laps, profiler::MIGRATE);
         for (int i = 0; i < tasks.size(); ++i)
         {
             if (tasks[i].curr_migrate_count == 0 || flags_vis[i])
@@ -249,69 +339,97 @@ std::tuple<std::vector<std::vector<int>>, double, std::vector<SnapShot>> run_alg
                 for (int j = 0; j < expt_groups[tasks[i].type].size(); ++j)
                 {
                     int expt_idx = expt_groups[tasks[i].type][j];
-                    double rand_num = (double)rand() / RAND_MAX;
-                    if (experts[expt_idx].num_idle_channel > 0 && rand_num < EPSILON)
+                    if (experts[expt_idx].num_idle_channel > 0 && rand_utils::bernoulli(rng, EPSILON))
                     {
+                        release_task(experts[tasks[i].each_stay_expert_id[tasks[i].curr_migrate_count - 1]], i, env_tm);
                         assign_task(tasks[i], experts[expt_idx], i, expt_idx, env_tm);
-                        flags_vis[i] = true;
+                        misplaced.update(tasks, experts, i);
+                        flags_vis.set(i);
                         break;
                     }
                 }
             }
         }
-        // try swap tasks
-        for (int i = 0; i < tasks.size() - 1; ++i)
+        // rotate migration cycles, each task of a cycle moves onto the suitable expert held by the next one
+        auto movable = [&](const int i) -> bool {
+            return !flags_vis[i] && tasks[i].curr_migrate_count < monte_utils::TASK_MAX_MIGRATION;
+        };
+        auto rotate = [&](const int *cycle, const int size) {
+            rotate_tasks(tasks, experts, cycle, size, env_tm);
+            for (int k = 0; k < size; ++k)
+            {
+                misplaced.update(tasks, experts, cycle[k]);
+                flags_vis.set(cycle[k]);
+            }
+        };
+        misplaced.resolve_migration_cycles(tasks, experts, expt_groups, movable, rotate);
+        // try swap tasks, both the tasks and their partners are taken from the index of misplaced tasks
+        PROFILE_LAP(laps, profiler::SWAP);
+        for (int i : misplaced.snapshot())
         {
-            if (tasks[i].curr_migrate_count == 0 || flags_vis[i] || tasks[i].curr_migrate_count == monte_utils::TASK_MAX_MIGRATION)
+            if (!misplaced.contains(i) || flags_vis[i] || tasks[i].curr_migrate_count == monte_utils::TASK_MAX_MIGRATION)
                 continue;
             int expt_idx_i = tasks[i].each_stay_expert_id[tasks[i].curr_migrate_count - 1];
-            if (experts[expt_idx_i].process_type_duras[tasks[i].type] < monte_utils::EXPERT_NOT_GOOD_TIME)
-                continue;
-            for (int j = i + 1; j < tasks.size(); ++j)
+            int j = misplaced.find_swap_partner(tasks, experts, expt_groups, i, [&](const int j) -> bool {
+                if (j < i || flags_vis[j] || tasks[j].curr_migrate_count == monte_utils::TASK_MAX_MIGRATION)
+                    return false;
+                int expt_idx_j = tasks[j].each_stay_expert_id[tasks[j].curr_migrate_count - 1];
+                return rand_utils::bernoulli(rng, EPSILON) && swap_check(tasks[i], tasks[j], experts[expt_idx_i], experts[expt_idx_j]);
+            });
+            if (j != -1)
             {
-                if (tasks[j].curr_migrate_count == 0 || flags_vis[j] || tasks[j].curr_migrate_count == monte_utils::TASK_MAX_MIGRATION)
-                    continue;
+                // both swap to suitable expert
                 int expt_idx_j = tasks[j].each_stay_expert_id[tasks[j].curr_migrate_count - 1];
-                if (experts[expt_idx_j].process_type_duras[tasks[j].type] < monte_utils::EXPERT_NOT_GOOD_TIME)
-                    continue;
-                double rand_num = (double)rand() / RAND_MAX;
-                // try swap
-                if (rand_num < EPSILON && swap_check(tasks[i], tasks[j], experts[expt_idx_i], experts[expt_idx_j]))
-                {
-                    // both swap to suitable expert
-                    swap_tasks(tasks[i], tasks[j], experts[expt_idx_i], experts[expt_idx_j], i, j, expt_idx_i, expt_idx_j, env_tm);
-                    flags_vis[i] = true;
-                    flags_vis[j] = true;
-                    break;
-                }
+                swap_tasks(tasks[i], tasks[j], experts[expt_idx_i], experts[expt_idx_j], i, j, expt_idx_i, expt_idx_j, env_tm);
+                misplaced.update(tasks, experts, i);
+                misplaced.update(tasks, experts, j);
+                flags_vis.set(i);
+                flags_vis.set(j);
             }
         }
 
+        PROFILE_LAP_END(laps);
         env_tm++;
-        // update expert flag
-        for (int i = 0; i < experts.size(); ++i)
+        // record the tasks and experts changed at this tick for snapshot deltas
+        for (int i = 0; i < tasks.size(); ++i)
         {
-            if (experts[i].num_idle_channel < monte_utils::EXPERT_MAX_PARALLEL)
-                experts[i].busy_sum++;
+            if (!flags_vis[i])
+                continue;
+            dirty_tasks.mark(i);
+            dirty_experts.mark(tasks[i].each_stay_expert_id[tasks[i].curr_migrate_count - 1]);
+            if (tasks[i].curr_migrate_count > 1)
+                dirty_experts.mark(tasks[i].each_stay_expert_id[tasks[i].curr_migrate_count - 2]);
         }
         if (env_tm - 1 == snap_shot_beg)
         {
             snap_shot_beg += take_snapshot_gap;
-            snapshots.emplace_back(SnapShot(env_tm, tasks, experts, flags_finish));
+            SnapShotChain::Delta delta;
+            for (int i : dirty_tasks.idxs)
+            {
+                delta.tasks.emplace_back(i, tasks[i]);
+                if (flags_finish[i])
+                    delta.finish_idxs.push_back(i);
+            }
+            for (int i : dirty_experts.idxs)
+                delta.experts.emplace_back(i, experts[i]);
+            dirty_tasks.clear();
+            dirty_experts.clear();
+            chain->deltas.emplace_back(std::move(delta));
+            snapshots.emplace_back(SnapShot(env_tm, chain, (int)chain->deltas.size() - 1));
         }
     }
 
-    std::vector<std::vector<int>> result = extract_result(tasks, experts);
+    std::vector<monte_utils::Assignment> result = extract_result(tasks, experts);
     double score = monte_metrics::score(tasks, experts);
     for (int i = 0; i < snapshots.size(); ++i)
         snapshots[i].score = score;
-    return std::make_tuple(result, score, snapshots);
+    return std::make_tuple(std::move(result), score, std::move(snapshots));
 }
 
 /**
- * save result into csv file
+ * save result into csv file, the file is written by the background writer
  */
-void save_result(std::vector<std::vector<int>> &result)
+void save_result(std::vector<monte_utils::Assignment> result)
 {
     time_t date = time(nullptr);
     tm *date_tm = localtime(&date);
@@ -319,35 +437,36 @@ void save_result(std::vector<std::vector<int>> &result)
     sprintf(result_tm_stamp, "%02d%02d%02d_%02d%02d%02d.csv", date_tm->tm_year + 1900 - 2000,
             date_tm->tm_mon + 1, date_tm->tm_mday, date_tm->tm_hour, date_tm->tm_min, date_tm->tm_sec);
     char prefix[100] = "\0";
-    strncpy(prefix, utils::PRED_RESULT_PREFIX, sizeof(utils::PRED_RESULT_PREFIX));
-    utils::save_result(strcat(prefix, result_tm_stamp), result);
+    strncpy(prefix, monte_utils::PRED_RESULT_PREFIX, sizeof(monte_utils::PRED_RESULT_PREFIX));
+    result_writer::global_writer().submit(strcat(prefix, result_tm_stamp), std::move(result));
 }
 
 int main(int argc, char const *argv[])
 {
-    double best_score = 0;
+    best_board::BestBoard board([](const best_board::Incumbent &inc) { shm_board::global_board().push(inc.score, inc.solution); },
+                                [](const best_board::Incumbent &inc) { save_result(inc.solution); },
+                                SAVE_INTERVAL);
+    // only results beating the incumbent of other processes are kept
+    shm_board::global_board().sync(board);
     std::vector<SnapShot> snap_shots;
     // generate initial snapshots from the very beginning
     std::vector<std::vector<int>> expt_groups;
+    const uint64_t seed = rand_utils::master_seed(argc, argv);
     std::cout << "Generate initial solutions..." << std::endl;
     for (int iter = 1; iter <= 1; ++iter)
     {
-        srand(time(nullptr));
-        std::vector<monte_utils::Task> tasks = monte_utils::load_tasks();
+        rand_utils::Xoshiro256 rng = rand_utils::job_stream(seed, 0);
+        std::vector<monte_utils::Task> tasks = shm_board::global_board().load_tasks();
         std::sort(tasks.begin(), tasks.end(), [](const monte_utils::Task &a, const monte_utils::Task &b) -> bool {
             if (a.generate_tm != b.generate_tm)
                 return a.generate_tm < b.generate_tm;
             else
                 return a.task_id < b.task_id;
         });
-        std::vector<monte_utils::Expert> experts = monte_utils::load_experts();
+        std::vector<monte_utils::Expert> experts = shm_board::global_board().load_experts();
         expt_groups = group_experts(experts, monte_utils::NUM_TASK_TYPE);
-        std::tuple<std::vector<std::vector<int>>, double, std::vector<SnapShot>> ret = run_alg(tasks, experts, std::vector<bool>(), expt_groups, 0, false);
-        if (std::get<1>(ret) > best_score)
-        {
-            best_score = std::get<1>(ret);
-            save_result(std::get<0>(ret));
-        }
+        std::tuple<std::vector<monte_utils::Assignment>, double, std::vector<SnapShot>> ret = run_alg(tasks, experts, std::vector<bool>(), expt_groups, 0, false, rng);
+        board.offer(std::get<1>(ret), [&]() { return std::move(std::get<0>(ret)); });
         // add snapshots
         std::cout << ">> Add snapshots " << std::get<2>(ret).size() << std::endl;
         snap_shots.insert(snap_shots.end(), std::get<2>(ret).begin(), std::get<2>(ret).end());
@@ -360,7 +479,7 @@ int main(int argc, char const *argv[])
     std::cout << "Start iterations ..." << std::endl;
     for (int iter = 1; iter <= 1000; ++iter)
     {
-        std::cout << ">>> Iter #" << iter << " best score=" << best_score << std::endl;
+        std::cout << ">>> Iter #" << iter << " best score=" << board.score() << std::endl;
         std::sort(snap_shots.begin(), snap_shots.end(), [](const SnapShot &a, const SnapShot &b) -> bool {
             if(abs(a.score-b.score) > 0.01)
                 return a.score < b.score;
@@ -374,36 +493,28 @@ int main(int argc, char const *argv[])
             int remove_size = (int)snap_shots.size() - SNAP_SHOT_MAX_KEEP;
             snap_shots.erase(snap_shots.begin(), snap_shots.begin() + remove_size);
         }
-        // try from each snapshots
+        // try from each snapshots as jobs of the pool, each restart owns a generator seeded by (iter, i),
+        // results are kept by snapshot index so merging below is independent of thread scheduling
         int shot_size = snap_shots.size();
         std::vector<std::vector<SnapShot>> tmp_snps(shot_size);
-        std::vector<double> snap_scores(shot_size, 0);
-        std::vector<std::vector<std::vector<int>>> snap_solutions(shot_size);
-        for (int i = 0; i < shot_size; ++i)
-        {
-            std::tuple<std::vector<std::vector<int>>, double, std::vector<SnapShot>> ret = run_alg(snap_shots[i].tasks, snap_shots[i].experts,
-                                                                                                   snap_shots[i].flags_finish,
-                                                                                                   expt_groups, snap_shots[i].snap_shot_tm, true);
-            snap_scores[i] = std::get<1>(ret);
-            snap_solutions[i] = std::get<0>(ret);
-            tmp_snps[i] = std::get<2>(ret);
-        }
-        // check best score and add snpshots
-        int best_idx = 0;
-        for (int i = 0; i < shot_size; ++i)
-        {
-            if (snap_scores[i] > best_score)
-            {
-                best_idx = i;
-                best_score = snap_scores[i];
-            }
-        }
-        std::cout << ">>>> Iter " << iter << " best score=" << best_score << std::endl;
-        save_result(snap_solutions[best_idx]);
+        thread_pool::global_pool().parallel_for(shot_size, [&](const int i) {
+            rand_utils::Xoshiro256 rng = rand_utils::job_stream(seed, ((uint64_t)iter << 32) | i);
+            std::vector<monte_utils::Task> tasks;
+            std::vector<monte_utils::Expert> experts;
+            std::vector<bool> flags_finish;
+            snap_shots[i].materialize(tasks, experts, flags_finish);
+            std::tuple<std::vector<monte_utils::Assignment>, double, std::vector<SnapShot>> ret = run_alg(tasks, experts, flags_finish,
+                                                                                                          expt_groups, snap_shots[i].snap_shot_tm, true, rng);
+            board.offer(std::get<1>(ret), [&]() { return std::move(std::get<0>(ret)); });
+            tmp_snps[i] = std::move(std::get<2>(ret));
+        });
+        // add snpshots
+        std::cout << ">>>> Iter " << iter << " best score=" << board.score() << std::endl;
         for (int i = 0; i < shot_size; ++i)
             snap_shots.insert(snap_shots.end(), tmp_snps[i].begin(), tmp_snps[i].end());
         if (iter % 100 == 0)
             EPSILON *= 0.8;
     }
+    board.flush();
     return 0;
 }
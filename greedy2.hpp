@@ -0,0 +1,369 @@
+/**
+ * This is a greedy method, based on best fit spt_benchmark, but add migration
+ */
+
+#pragma once
+#include "best_board.hpp"
+#include "monte_metrics.hpp"
+#include "monte_utils.hpp"
+#include "profiler.hpp"
+#include "rand_utils.hpp"
+#include "result_writer.hpp"
+#include "shm_board.hpp"
+#include "thread_pool.hpp"
+
+namespace greedy2
+{
+
+static double EPSILON = 0.9;
+static const int NUM_RUNS = 8000; // randomized greedy runs of the portfolio
+static const double SAVE_INTERVAL = 10; // seconds between two saves of the improving best result
+
+/**
+ * save result into csv file, the file is written by the background writer
+ */
+void save_result(std::vector<monte_utils::Assignment> result, double score)
+{
+    time_t date = time(nullptr);
+    tm *date_tm = localtime(&date);
+    char result_tm_stamp[50];
+    sprintf(result_tm_stamp, "%02d%02d%02d_%02d%02d%02d_score_%lf.csv", date_tm->tm_year + 1900 - 2000,
+            date_tm->tm_mon + 1, date_tm->tm_mday, date_tm->tm_hour, date_tm->tm_min, date_tm->tm_sec, score);
+    char prefix[100] = "\0";
+    strncpy(prefix, monte_utils::PRED_RESULT_PREFIX, sizeof(monte_utils::PRED_RESULT_PREFIX));
+    result_writer::global_writer().submit(strcat(prefix, result_tm_stamp), std::move(result));
+}
+
+/**
+ * Extract result, each row is task id, expert id and time
+ */
+std::vector<monte_utils::Assignment> extract_result(const std::vector<monte_utils::Task> &tasks, const std::vector<monte_utils::Expert> &experts)
+{
+    std::vector<monte_utils::Assignment> result;
+    result.reserve(tasks.size());
+    for (int i = 0; i < tasks.size(); ++i)
+    {
+        for (int j = 0; j < tasks[i].curr_migrate_count; ++j)
+        {
+            result.push_back({tasks[i].task_id, experts[tasks[i].each_stay_expert_id[j]].expert_id, tasks[i].assign_tm[j]});
+        }
+    }
+    monte_utils::sort_assignments(result);
+    return result;
+}
+
+/**
+ * check if two task swap is valid
+ */
+bool swap_check(monte_utils::Task &task_i, monte_utils::Task &task_j, monte_utils::Expert &expert_i, monte_utils::Expert &expert_j)
+{
+    bool flag1 = ((expert_i.process_type_duras[task_i.type] == monte_utils::EXPERT_NOT_GOOD_TIME) &&
+                  (expert_i.process_type_duras[task_j.type] < monte_utils::EXPERT_NOT_GOOD_TIME) &&
+                  (expert_j.process_type_duras[task_j.type] == monte_utils::EXPERT_NOT_GOOD_TIME) &&
+                  (expert_j.process_type_duras[task_i.type] < monte_utils::EXPERT_NOT_GOOD_TIME) &&
+                  (task_i.curr_migrate_count < monte_utils::TASK_MAX_MIGRATION) &&
+                  (task_j.curr_migrate_count < monte_utils::TASK_MAX_MIGRATION)),
+         flag2 = ((expert_i.process_type_duras[task_i.type] == monte_utils::EXPERT_NOT_GOOD_TIME) &&
+                  (expert_i.process_type_duras[task_j.type] < monte_utils::EXPERT_NOT_GOOD_TIME) &&
+                  (expert_j.process_type_duras[task_j.type] == monte_utils::EXPERT_NOT_GOOD_TIME) &&
+                  (expert_j.process_type_duras[task_i.type] == monte_utils::EXPERT_NOT_GOOD_TIME) &&
+                  (task_i.curr_migrate_count + 1 < monte_utils::TASK_MAX_MIGRATION) &&
+                  (task_j.curr_migrate_count < monte_utils::TASK_MAX_MIGRATION)),
+         flag3 = ((expert_i.process_type_duras[task_i.type] == monte_utils::EXPERT_NOT_GOOD_TIME) &&
+                  (expert_i.process_type_duras[task_j.type] == monte_utils::EXPERT_NOT_GOOD_TIME) &&
+                  (expert_j.process_type_duras[task_j.type] == monte_utils::EXPERT_NOT_GOOD_TIME) &&
+                  (expert_j.process_type_duras[task_i.type] < monte_utils::EXPERT_NOT_GOOD_TIME) &&
+                  (task_i.curr_migrate_count < monte_utils::TASK_MAX_MIGRATION) &&
+                  (task_j.curr_migrate_count + 1 < monte_utils::TASK_MAX_MIGRATION));
+    return flag1 || flag2 || flag3;
+}
+
+/**
+ * Group experts by good at processing types, one expert may belong to multiple group
+ */
+std::vector<std::vector<int>> group_experts(const std::vector<monte_utils::Expert> &experts, const int num_types)
+{
+    PROFILE_SCOPE(profiler::GROUP_EXPERTS);
+    std::vector<std::vector<int>> expt_groups(num_types);
+    for (int i = 0; i < experts.size(); ++i)
+    {
+        for (int j = 0; j < num_types; ++j)
+        {
+            if (experts[i].process_type_duras[j] < monte_utils::EXPERT_NOT_GOOD_TIME)
+                expt_groups[j].push_back(i);
+        }
+    }
+    for (int i = 0; i < expt_groups.size(); ++i)
+    {
+        std::sort(expt_groups[i].begin(), expt_groups[i].end(), [&experts, i](const int a, const int b) -> bool {
+            if (experts[a].process_type_duras[i] != experts[b].process_type_duras[i])
+                return experts[a].process_type_duras[i] < experts[b].process_type_duras[i];
+            else
+                return experts[a].expert_id < experts[b].expert_id;
+        });
+    }
+    return expt_groups;
+}
+
+/**
+ * Assign a task to expert to process
+ */
+void assign_task(monte_utils::Task &task, monte_utils::Expert &expert, const int task_idx, const int expert_idx, const int env_tm)
+{
+    if (task.start_process_tm == -1)
+        task.start_process_tm = env_tm;
+    task.each_stay_expert_id[task.curr_migrate_count] = expert_idx;
+    task.assign_tm[task.curr_migrate_count] = env_tm;
+    task.curr_migrate_count++;
+    for (int i = 0; i < monte_utils::EXPERT_MAX_PARALLEL; ++i)
+    {
+        if (expert.channels[i] == -1)
+        {
+            expert.channels[i] = task_idx;
+            expert.take_channel(env_tm);
+            break;
+        }
+    }
+}
+
+/**
+ * Release task from expert
+ */
+void release_task(monte_utils::Expert &expert, const int task_idx, const int env_tm)
+{
+    for (int i = 0; i < monte_utils::EXPERT_MAX_PARALLEL; ++i)
+    {
+        if (expert.channels[i] == task_idx)
+        {
+            expert.channels[i] = -1;
+            expert.free_channel(env_tm);
+            break;
+        }
+    }
+}
+
+/**
+ * swap two tasks
+ */
+void swap_tasks(monte_utils::Task &task_a, monte_utils::Task &task_b,
+                monte_utils::Expert &expert_a, monte_utils::Expert &expert_b, int task_a_idx, int task_b_idx,
+                int expert_a_idx, int expert_b_idx, int env_tm)
+{
+    // release resources
+    release_task(expert_a, task_a_idx, env_tm);
+    release_task(expert_b, task_b_idx, env_tm);
+    assign_task(task_a, expert_b, task_a_idx, expert_b_idx, env_tm);
+    assign_task(task_b, expert_a, task_b_idx, expert_a_idx, env_tm);
+}
+
+/**
+ * Rotate tasks of a migration cycle, cycle[k] moves onto the expert of cycle[(k + 1) % size]
+ */
+void rotate_tasks(std::vector<monte_utils::Task> &tasks, std::vector<monte_utils::Expert> &experts, const int *cycle,
+                  const int size, const int env_tm)
+{
+    for (int k = 0; k < size; ++k)
+        release_task(experts[tasks[cycle[k]].each_stay_expert_id[tasks[cycle[k]].curr_migrate_count - 1]], cycle[k], env_tm);
+    // the expert of cycle[k + 1] is still recorded when cycle[k] moves, only the first one needs saving
+    int first_expt_idx = tasks[cycle[0]].each_stay_expert_id[tasks[cycle[0]].curr_migrate_count - 1];
+    for (int k = 0; k < size; ++k)
+    {
+        int expt_idx = k + 1 < size ? tasks[cycle[k + 1]].each_stay_expert_id[tasks[cycle[k + 1]].curr_migrate_count - 1] : first_expt_idx;
+        assign_task(tasks[cycle[k]], experts[expt_idx], cycle[k], expt_idx, env_tm);
+    }
+}
+
+/**
+ * The instance loaded, sorted and grouped once, shared read-only by all workers
+ */
+struct Instance
+{
+    std::vector<monte_utils::Task> tasks; // sorted by generate time
+    std::vector<monte_utils::Expert> experts;
+    std::vector<std::vector<int>> expt_groups;
+};
+
+/**
+ * State of one pool slot, restored from the instance at each run, the buffers are kept across runs
+ */
+struct Worker
+{
+    std::vector<monte_utils::Task> tasks;
+    std::vector<monte_utils::Expert> experts;
+    std::vector<std::vector<int>> expt_groups; // reordered by the run
+    monte_utils::MisplacedTasks misplaced;
+    monte_utils::EpochFlags vis; // tasks operated at current tick
+    rand_utils::Xoshiro256 rng;  // the generator of the current run
+
+    Worker(const Instance &instance) : vis(instance.tasks.size()) {}
+
+    void reset(const Instance &instance, const rand_utils::Xoshiro256 &run_rng)
+    {
+        tasks = instance.tasks;
+        experts = instance.experts;
+        expt_groups = instance.expt_groups;
+        misplaced.init(tasks, experts, expt_groups.size());
+        rng = run_rng;
+    }
+};
+
+/**
+ * Best fit add migrations, return the score of the run, the final state is left in the worker
+ */
+double run_alg(Worker &worker)
+{
+    std::vector<monte_utils::Task> &tasks = worker.tasks;
+    std::vector<monte_utils::Expert> &experts = worker.experts;
+    std::vector<std::vector<int>> &expt_groups = worker.expt_groups;
+    monte_utils::MisplacedTasks &misplaced = worker.misplaced;
+    monte_utils::EpochFlags &vis = worker.vis;
+    int num_finish = 0, env_tm = 0;
+    while (num_finish < tasks.size())
+    {
+        PROFILE_COUNT(profiler::TICKS, 1);
+        PROFILE_LAPS(laps);
+        vis.clear();
+        // check finish
+        PROFILE_LAP(laps, profiler::FINISH_CHECK);
+        for (int i = 0; i < tasks.size(); ++i)
+        {
+            if (tasks[i].curr_migrate_count == 0 || tasks[i].finish_tm != -1)
+                continue;
+            int expert_idx = tasks[i].each_stay_expert_id[tasks[i].curr_migrate_count - 1];
+            int process_due = tasks[i].assign_tm[tasks[i].curr_migrate_count - 1] + experts[expert_idx].process_type_duras[tasks[i].type];
+            if (env_tm == process_due)
+            {
+                release_task(experts[expert_idx], i, env_tm);
+                tasks[i].finish_tm = env_tm;
+                misplaced.update(tasks, experts, i);
+                vis.set(i);
+                num_finish++;
+            }
+        }
+        // check new generated tasks, try assign to best fit expert
+        PROFILE_LAP(laps, profiler::ASSIGN);
+        for (int i = 0; i < tasks.size(); ++i)
+        {
+            if (tasks[i].curr_migrate_count > 0 || vis[i])
+                continue;
+            else if (tasks[i].generate_tm > env_tm)
+                break;
+            int task_type = tasks[i].type;
+            for (int &expt_idx : expt_groups[task_type])
+            {
+                if (experts[expt_idx].num_idle_channel > 0 && rand_utils::bernoulli(worker.rng, EPSILON))
+                {
+                    assign_task(tasks[i], experts[expt_idx], i, expt_idx, env_tm);
+                    std::sort(expt_groups[task_type].begin(), expt_groups[task_type].end(), [&experts, task_type, env_tm](const int a, const int b) -> bool {
+                        if (experts[a].process_type_duras[task_type] != experts[b].process_type_duras[task_type])
+                            return experts[a].process_type_duras[task_type] < experts[b].process_type_duras[task_type];
+                        else if (experts[a].busy_time(env_tm) != experts[b].busy_time(env_tm))
+                            return experts[a].busy_time(env_tm) < experts[b].busy_time(env_tm);
+                        else if (experts[a].num_idle_channel != experts[b].num_idle_channel)
+                            return experts[a].num_idle_channel > experts[b].num_idle_channel;
+                        else
+                            return experts[a].expert_id < experts[b].expert_id;
+                    });
+                    misplaced.update(tasks, experts, i);
+                    vis.set(i);
+                    break;
+                }
+            }
+        }
+        // check for new generated tasks that not found best fit
+        for (int i = 0; i < tasks.size(); ++i)
+        {
+            if (vis[i] || tasks[i].curr_migrate_count > 0)
+                continue;
+            else if (tasks[i].generate_tm > env_tm)
+                break;
+            for (int j = experts.size() - 1; j >= 0; --j)
+            {
+                if (experts[j].num_idle_channel > 0)
+                {
+                    assign_task(tasks[i], experts[j], i, j, env_tm);
+                    misplaced.update(tasks, experts, i);
+                    vis.set(i);
+                    break;
+                }
+            }
+        }
+        // check for migrate for already assigned tasks
+        PROFILE_LAP(laps, profiler::MIGRATE);
+        for (int i = 0; i < tasks.size(); ++i)
+        {
+            if (vis[i] || tasks[i].finish_tm != -1 || tasks[i].curr_migrate_count == 0 ||
+                tasks[i].curr_migrate_count == monte_utils::TASK_MAX_MIGRATION ||
+                experts[tasks[i]
+                            .each_stay_expert_id[tasks[i].curr_migrate_count - 1]]
+                        .process_type_duras[tasks[i].type] < monte_utils::EXPERT_NOT_GOOD_TIME)
+                continue;
+            else if (tasks[i].generate_tm > env_tm)
+                break;
+            int task_type = tasks[i].type;
+            for (int &expt_idx : expt_groups[task_type])
+            {
+                if (experts[expt_idx].num_idle_channel > 0 && rand_utils::bernoulli(worker.rng, EPSILON))
+                {
+                    release_task(experts[tasks[i].each_stay_expert_id[tasks[i].curr_migrate_count - 1]], i, env_tm);
+                    assign_task(tasks[i], experts[expt_idx], i, expt_idx, env_tm);
+                    std::sort(expt_groups[task_type].begin(), expt_groups[task_type].end(), [&experts, task_type, env_tm](const int a, const int b) -> bool {
+                        if (experts[a].process_type_duras[task_type] != experts[b].process_type_duras[task_type])
+                            return experts[a].process_type_duras[task_type] < experts[b].process_type_duras[task_type];
+                        else if (experts[a].busy_time(env_tm) != experts[b].busy_time(env_tm))
+                            return experts[a].busy_time(env_tm) < experts[b].busy_time(env_tm);
+                        else if (experts[a].num_idle_channel != experts[b].num_idle_channel)
+                            return experts[a].num_idle_channel > experts[b].num_idle_channel;
+                        else
+                            return experts[a].expert_id < experts[b].expert_id;
+                    });
+                    misplaced.update(tasks, experts, i);
+                    vis.set(i);
+                    break;
+                }
+            }
+        }
+        // rotate migration cycles, each task of a cycle moves onto the suitable expert held by the next one
+        auto movable = [&](const int i) -> bool {
+            return !vis[i] && tasks[i].curr_migrate_count < monte_utils::TASK_MAX_MIGRATION;
+        };
+        auto rotate = [&](const int *cycle, const int size) {
+            rotate_tasks(tasks, experts, cycle, size, env_tm);
+            for (int k = 0; k < size; ++k)
+            {
+                misplaced.update(tasks, experts, cycle[k]);
+                vis.set(cycle[k]);
+            }
+        };
+        misplaced.resolve_migration_cycles(tasks, experts, expt_groups, movable, rotate);
+        // check swap, both the tasks and their partners are taken from the index of misplaced tasks
+        PROFILE_LAP(laps, profiler::SWAP);
+        for (int i : misplaced.snapshot())
+        {
+            if (vis[i] || !misplaced.contains(i) || tasks[i].curr_migrate_count == monte_utils::TASK_MAX_MIGRATION)
+                continue;
+            int expt_i_idx = tasks[i].each_stay_expert_id[tasks[i].curr_migrate_count - 1];
+            int j = misplaced.find_swap_partner(tasks, experts, expt_groups, i, [&](const int j) -> bool {
+                if (j < i || vis[j] || tasks[j].curr_migrate_count == monte_utils::TASK_MAX_MIGRATION)
+                    return false;
+                int expt_j_idx = tasks[j].each_stay_expert_id[tasks[j].curr_migrate_count - 1];
+                return swap_check(tasks[i], tasks[j], experts[expt_i_idx], experts[expt_j_idx]) && rand_utils::bernoulli(worker.rng, EPSILON);
+            });
+            if (j != -1)
+            {
+                int expt_j_idx = tasks[j].each_stay_expert_id[tasks[j].curr_migrate_count - 1];
+                swap_tasks(tasks[i], tasks[j], experts[expt_i_idx], experts[expt_j_idx], i, j, expt_i_idx, expt_j_idx, env_tm);
+                misplaced.update(tasks, experts, i);
+                misplaced.update(tasks, experts, j);
+                vis.set(i);
+                vis.set(j);
+            }
+        }
+
+        env_tm++;
+    }
+
+    return monte_metrics::score(tasks, experts);
+}
+
+} // namespace greedy2
@@ -0,0 +1,247 @@
+/**
+ * Synthetic instance generator for scaling studies, built by `make instance_gen`
+ * It writes work_order.csv and process_time_matrix.csv in the format of the competition instance, the methods load them
+ * when the environment variable INSTANCE_DIR names the output directory, e.g.
+ *   ./instance_gen 7 tasks=80000 experts=1330 dir=../data/x10
+ *   INSTANCE_DIR=../data/x10 ./a.out
+ * The first argument is the seed, the others are name=value parameters listed in `Params`, an instance is reproducible
+ * from its seed and parameters. The generator and the methods are built for TASK_TYPES types, build all of them
+ * with -DTASK_TYPES=<n> for an instance of n types, the generator refuses other types
+ */
+
+#include "monte_utils.hpp"
+#include "rand_utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+struct Params
+{
+    std::string dir = "../data/generated";
+    int tasks = 8000;
+    int experts = 133;
+    int types = monte_utils::NUM_TASK_TYPE;
+    int horizon = 3000;        // time slots over which tasks are generated
+    double density = 0.06;     // probability of an expert being suitable for a type
+    double dura_median = 30;   // processing time of a suitable expert, log normal
+    double dura_sigma = 0.8;   // sigma of the log of processing time
+    int dura_max = 600;
+    double burst = 0.3;        // ratio of tasks generated in bursts, others are generated uniformly over the horizon
+    int bursts = 20;           // number of bursts
+    int burst_len = 30;        // time slots of a burst
+    int resp_min = 60;         // max response time is drawn from resp_min, resp_min + resp_step, ..., resp_max
+    int resp_max = 180;
+    int resp_step = 60;
+
+    /**
+     * Set the parameter of a name=value argument
+     * @return false if the argument names no parameter
+     */
+    bool set(const char *arg)
+    {
+        const char *eq = strchr(arg, '=');
+        if (eq == nullptr)
+            return false;
+        std::string name(arg, eq - arg);
+        const char *val = eq + 1;
+        if (name == "dir")
+            dir = val;
+        else if (name == "tasks")
+            tasks = atoi(val);
+        else if (name == "experts")
+            experts = atoi(val);
+        else if (name == "types")
+            types = atoi(val);
+        else if (name == "horizon")
+            horizon = atoi(val);
+        else if (name == "density")
+            density = atof(val);
+        else if (name == "dura_median")
+            dura_median = atof(val);
+        else if (name == "dura_sigma")
+            dura_sigma = atof(val);
+        else if (name == "dura_max")
+            dura_max = atoi(val);
+        else if (name == "burst")
+            burst = atof(val);
+        else if (name == "bursts")
+            bursts = atoi(val);
+        else if (name == "burst_len")
+            burst_len = atoi(val);
+        else if (name == "resp_min")
+            resp_min = atoi(val);
+        else if (name == "resp_max")
+            resp_max = atoi(val);
+        else if (name == "resp_step")
+            resp_step = atoi(val);
+        else
+            return false;
+        return true;
+    }
+
+    bool valid() const
+    {
+        return tasks > 0 && experts > 0 && types > 0 && horizon > 0 && density >= 0 && dura_median >= 1 && dura_max >= 1 &&
+               burst >= 0 && burst <= 1 && bursts > 0 && burst_len > 0 && resp_min > 0 && resp_max >= resp_min && resp_step > 0;
+    }
+};
+
+/**
+ * Processing time of a suitable expert, log normal around the median and clamped to [1, dura_max]
+ */
+int draw_dura(rand_utils::Xoshiro256 &rng, const Params &params)
+{
+    double u1 = 1 - rand_utils::uniform(rng), u2 = rand_utils::uniform(rng);
+    double z = sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+    int dura = (int)lround(params.dura_median * exp(params.dura_sigma * z));
+    return std::min(std::max(dura, 1), params.dura_max);
+}
+
+/**
+ * Processing times of each expert for each type, every type has a suitable expert and every expert is suitable for a type
+ */
+std::vector<std::vector<int>> gen_experts(rand_utils::Xoshiro256 &rng, const Params &params)
+{
+    std::vector<std::vector<int>> duras(params.experts, std::vector<int>(params.types, monte_utils::EXPERT_NOT_GOOD_TIME));
+    for (int i = 0; i < params.experts; ++i)
+    {
+        for (int t = 0; t < params.types; ++t)
+        {
+            if (rand_utils::bernoulli(rng, params.density))
+                duras[i][t] = draw_dura(rng, params);
+        }
+    }
+    for (int t = 0; t < params.types; ++t)
+    {
+        bool suited = false;
+        for (int i = 0; i < params.experts && !suited; ++i)
+            suited = duras[i][t] != monte_utils::EXPERT_NOT_GOOD_TIME;
+        if (!suited)
+            duras[rand_utils::below(rng, params.experts)][t] = draw_dura(rng, params);
+    }
+    for (int i = 0; i < params.experts; ++i)
+    {
+        if (std::count(duras[i].begin(), duras[i].end(), monte_utils::EXPERT_NOT_GOOD_TIME) == params.types)
+            duras[i][rand_utils::below(rng, params.types)] = draw_dura(rng, params);
+    }
+    return duras;
+}
+
+/**
+ * Tasks of uniformly drawn types, sorted by generate time and numbered from 1, each row is generate time, type, max response time
+ */
+std::vector<monte_utils::Task> gen_tasks(rand_utils::Xoshiro256 &rng, const Params &params)
+{
+    std::vector<int> burst_begins(params.bursts);
+    for (int &begin : burst_begins)
+        begin = rand_utils::below(rng, params.horizon);
+    int num_resps = (params.resp_max - params.resp_min) / params.resp_step + 1;
+    std::vector<monte_utils::Task> tasks;
+    tasks.reserve(params.tasks);
+    for (int i = 0; i < params.tasks; ++i)
+    {
+        int generate_tm = rand_utils::bernoulli(rng, params.burst)
+                              ? burst_begins[rand_utils::below(rng, params.bursts)] + rand_utils::below(rng, params.burst_len)
+                              : rand_utils::below(rng, params.horizon);
+        int type = rand_utils::below(rng, params.types);
+        int max_resp = params.resp_min + rand_utils::below(rng, num_resps) * params.resp_step;
+        tasks.emplace_back(monte_utils::Task(0, generate_tm, type, max_resp));
+    }
+    std::stable_sort(tasks.begin(), tasks.end(), [](const monte_utils::Task &a, const monte_utils::Task &b) -> bool {
+        return a.generate_tm < b.generate_tm;
+    });
+    for (int i = 0; i < tasks.size(); ++i)
+        tasks[i].task_id = i + 1;
+    return tasks;
+}
+
+/**
+ * Create the directory and its missing parents
+ */
+void make_dirs(const std::string &dir)
+{
+    for (size_t pos = dir.find('/', 1); pos != std::string::npos; pos = dir.find('/', pos + 1))
+        mkdir(dir.substr(0, pos).c_str(), 0755);
+    mkdir(dir.c_str(), 0755);
+}
+
+bool write_instance(const Params &params, const std::vector<monte_utils::Task> &tasks, const std::vector<std::vector<int>> &duras)
+{
+    make_dirs(params.dir);
+    FILE *fp = fopen(monte_utils::instance_file(monte_utils::WORK_ORDER, params.dir.c_str()).c_str(), "w");
+    if (fp == nullptr)
+        return false;
+    for (const monte_utils::Task &task : tasks)
+        fprintf(fp, "%d,%d,%d,%d\n", task.task_id, task.generate_tm, task.type + 1, task.max_resp);
+    fclose(fp);
+    fp = fopen(monte_utils::instance_file(monte_utils::PROCESS_TM_MAT, params.dir.c_str()).c_str(), "w");
+    if (fp == nullptr)
+        return false;
+    fprintf(fp, "expert_id");
+    for (int t = 0; t < params.types; ++t)
+        fprintf(fp, ",%d", t + 1);
+    fprintf(fp, "\n");
+    for (int i = 0; i < duras.size(); ++i)
+    {
+        fprintf(fp, "%d", i + 1);
+        for (int dura : duras[i])
+            fprintf(fp, ",%d", dura);
+        fprintf(fp, "\n");
+    }
+    fclose(fp);
+    return true;
+}
+
+int main(int argc, char const *argv[])
+{
+    Params params;
+    int first_param = argc > 1 && strchr(argv[1], '=') == nullptr ? 2 : 1;
+    uint64_t seed = first_param == 2 ? strtoull(argv[1], nullptr, 10) : (uint64_t)time(nullptr);
+    for (int i = first_param; i < argc; ++i)
+    {
+        if (!params.set(argv[i]))
+        {
+            fprintf(stderr, "unknown parameter %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (!params.valid())
+    {
+        fprintf(stderr, "invalid parameters\n");
+        return 1;
+    }
+    // the methods load the instance only if they are built for the same types
+    if (params.types != monte_utils::NUM_TASK_TYPE)
+    {
+        fprintf(stderr, "built for %d types, build instance_gen and the methods with -DTASK_TYPES=%d for %d types\n",
+                monte_utils::NUM_TASK_TYPE, params.types, params.types);
+        return 1;
+    }
+    printf("seed=%llu\n", (unsigned long long)seed);
+    rand_utils::Xoshiro256 rng(seed);
+    std::vector<std::vector<int>> duras = gen_experts(rng, params);
+    std::vector<monte_utils::Task> tasks = gen_tasks(rng, params);
+    if (!write_instance(params, tasks, duras))
+    {
+        fprintf(stderr, "failed to write instance to %s\n", params.dir.c_str());
+        return 1;
+    }
+    // offered load, the processing time of tasks on their fastest experts over the channel time of the horizon
+    double work = 0;
+    for (const monte_utils::Task &task : tasks)
+    {
+        int fastest = monte_utils::EXPERT_NOT_GOOD_TIME;
+        for (const std::vector<int> &expert_duras : duras)
+            fastest = std::min(fastest, expert_duras[task.type]);
+        work += fastest;
+    }
+    printf("%d tasks, %d experts, %d types written to %s\n", params.tasks, params.experts, params.types, params.dir.c_str());
+    printf("offered load=%.3lf\n", work / ((double)params.experts * monte_utils::EXPERT_MAX_PARALLEL * params.horizon));
+    return 0;
+}
@@ -0,0 +1,188 @@
+/**
+ * Asynchronous logging for the search loops
+ * Each thread formats its messages into its own ring buffer, which only the thread writes and only the sink thread reads,
+ * so logging takes no lock and never waits for the console, messages are dropped and counted when a ring is full.
+ * The sink thread writes the messages of all rings to stdout, messages of one thread keep their order.
+ * Levels below LOG_LEVEL are removed at compile time, e.g. build with -DLOG_LEVEL=0 to print debug messages,
+ * their arguments are not evaluated
+ */
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL 1 // 0 debug, 1 info, 2 warn, 3 error
+#endif
+
+#define LOG_DEBUG(...)                  \
+    do                                  \
+    {                                   \
+        if (0 >= LOG_LEVEL)             \
+            logger::write(__VA_ARGS__); \
+    } while (0)
+#define LOG_INFO(...)                   \
+    do                                  \
+    {                                   \
+        if (1 >= LOG_LEVEL)             \
+            logger::write(__VA_ARGS__); \
+    } while (0)
+#define LOG_WARN(...)                   \
+    do                                  \
+    {                                   \
+        if (2 >= LOG_LEVEL)             \
+            logger::write(__VA_ARGS__); \
+    } while (0)
+#define LOG_ERROR(...)                  \
+    do                                  \
+    {                                   \
+        if (3 >= LOG_LEVEL)             \
+            logger::write(__VA_ARGS__); \
+    } while (0)
+
+namespace logger
+{
+
+static const uint32_t RING_SIZE = 1024; // messages of each ring, must be power of 2
+static const int MESSAGE_LEN = 256;     // longer messages are truncated
+static const int SINK_IDLE_US = 1000;   // sleep of the sink thread when all rings are empty
+
+struct Message
+{
+    int len;
+    char text[MESSAGE_LEN];
+};
+
+/**
+ * Single producer single consumer ring of messages
+ */
+struct Ring
+{
+    std::atomic<uint32_t> head; // next message to write, only advanced by the owning thread
+    std::atomic<uint32_t> tail; // next message to read, only advanced by the sink thread
+    std::atomic<uint64_t> num_dropped;
+    Message messages[RING_SIZE];
+
+    Ring() : head(0), tail(0), num_dropped(0) {}
+};
+
+struct Sink
+{
+    std::mutex mtx; // guards `rings`, taken by threads logging for the first time and by the sink thread to copy them
+    std::vector<std::unique_ptr<Ring>> rings;
+    std::vector<Ring *> drain_rings; // rings copied by the sink thread, so the lock is not held while writing
+    std::atomic<bool> stopping;
+    std::thread thread;
+
+    Sink() : stopping(false)
+    {
+        thread = std::thread([this]() { sink_loop(); });
+    }
+
+    /**
+     * Messages logged before are written before the sink stops, so nothing may be logged from later static destructors
+     */
+    ~Sink()
+    {
+        stopping.store(true, std::memory_order_release);
+        thread.join();
+    }
+
+    Ring *add_ring()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        rings.emplace_back(new Ring());
+        return rings.back().get();
+    }
+
+    /**
+     * Write the messages of all rings
+     * @return false if all rings are empty
+     */
+    bool drain()
+    {
+        bool written = false;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            drain_rings.resize(rings.size());
+            for (int i = 0; i < rings.size(); ++i)
+                drain_rings[i] = rings[i].get();
+        }
+        for (Ring *ring : drain_rings)
+        {
+            uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+            uint32_t head = ring->head.load(std::memory_order_acquire);
+            written = written || tail != head;
+            for (; tail != head; ++tail)
+            {
+                const Message &msg = ring->messages[tail & (RING_SIZE - 1)];
+                fwrite(msg.text, 1, msg.len, stdout);
+            }
+            ring->tail.store(head, std::memory_order_release);
+            uint64_t num_dropped = ring->num_dropped.exchange(0, std::memory_order_relaxed);
+            if (num_dropped > 0)
+            {
+                fprintf(stdout, "%llu log messages dropped\n", (unsigned long long)num_dropped);
+                written = true;
+            }
+        }
+        if (written)
+            fflush(stdout);
+        return written;
+    }
+
+    void sink_loop()
+    {
+        while (true)
+        {
+            bool stop = stopping.load(std::memory_order_acquire);
+            if (drain())
+                continue;
+            if (stop)
+                return;
+            std::this_thread::sleep_for(std::chrono::microseconds(SINK_IDLE_US));
+        }
+    }
+};
+
+/**
+ * The sink of the process, created on first use
+ */
+Sink &sink()
+{
+    static Sink s;
+    return s;
+}
+
+/**
+ * Log a printf style message, a new line is appended, use the LOG_* macros instead so that levels can be removed
+ */
+__attribute__((format(printf, 1, 2))) void write(const char *fmt, ...)
+{
+    static thread_local Ring *ring = sink().add_ring();
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) == RING_SIZE)
+    {
+        ring->num_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Message &msg = ring->messages[head & (RING_SIZE - 1)];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(msg.text, MESSAGE_LEN - 1, fmt, args);
+    va_end(args);
+    len = std::min(std::max(len, 0), MESSAGE_LEN - 2);
+    msg.text[len] = '\n';
+    msg.len = len + 1;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+} // namespace logger
@@ -0,0 +1,461 @@
+/**
+ * This is a dispatcher matching ready tasks to idle channels in batch at each time slot, instead of assigning tasks
+ * one by one in array order, the assignment of each time slot is a min cost bipartite matching
+ */
+#include "monte_metrics.hpp"
+#include "monte_utils.hpp"
+#include "result_writer.hpp"
+#include <deque>
+#include <tuple>
+
+static const double WAIT_COST = 10000;    // base cost of leaving a task waiting, larger than any assignment cost
+static const double BALANCE_WEIGHT = 100; // cost per busy ratio of the expert, prefers experts with less workload
+static const double AUCTION_EPS = 1e-3;   // min raise of a bid, the cost of the matching is within it per task of the min cost
+static const double AUCTION_EPS_START = WAIT_COST / 10; // min raise of the first round of bids
+static const double AUCTION_EPS_DIV = 10; // each round of bids divides the min raise by it, until AUCTION_EPS
+
+/**
+ * save result into csv file, the file is written by the background writer
+ */
+void save_result(std::vector<monte_utils::Assignment> result, double score)
+{
+    time_t date = time(nullptr);
+    tm *date_tm = localtime(&date);
+    char result_tm_stamp[80];
+    snprintf(result_tm_stamp, sizeof(result_tm_stamp), "%02d%02d%02d_%02d%02d%02d_score_%lf.csv", date_tm->tm_year + 1900 - 2000,
+            date_tm->tm_mon + 1, date_tm->tm_mday, date_tm->tm_hour, date_tm->tm_min, date_tm->tm_sec, score);
+    char prefix[100] = "\0";
+    strncpy(prefix, monte_utils::PRED_RESULT_PREFIX, sizeof(monte_utils::PRED_RESULT_PREFIX));
+    result_writer::global_writer().submit(strcat(prefix, result_tm_stamp), std::move(result));
+}
+
+/**
+ * Extract result, each row is task id, expert id and time
+ */
+std::vector<monte_utils::Assignment> extract_result(const std::vector<monte_utils::Task> &tasks, const std::vector<monte_utils::Expert> &experts)
+{
+    std::vector<monte_utils::Assignment> result;
+    result.reserve(tasks.size());
+    for (int i = 0; i < tasks.size(); ++i)
+    {
+        for (int j = 0; j < tasks[i].curr_migrate_count; ++j)
+        {
+            result.push_back({tasks[i].task_id, experts[tasks[i].each_stay_expert_id[j]].expert_id, tasks[i].assign_tm[j]});
+        }
+    }
+    monte_utils::sort_assignments(result);
+    return result;
+}
+
+/**
+ * Assign a task to expert to process
+ */
+void assign_task(monte_utils::Task &task, monte_utils::Expert &expert, const int task_idx, const int expert_idx, const int env_tm)
+{
+    if (task.start_process_tm == -1)
+        task.start_process_tm = env_tm;
+    task.each_stay_expert_id[task.curr_migrate_count] = expert_idx;
+    task.assign_tm[task.curr_migrate_count] = env_tm;
+    task.curr_migrate_count++;
+    for (int i = 0; i < monte_utils::EXPERT_MAX_PARALLEL; ++i)
+    {
+        if (expert.channels[i] == -1)
+        {
+            expert.channels[i] = task_idx;
+            expert.take_channel(env_tm);
+            break;
+        }
+    }
+}
+
+/**
+ * Release task from expert
+ */
+void release_task(monte_utils::Expert &expert, const int task_idx, const int env_tm)
+{
+    for (int i = 0; i < monte_utils::EXPERT_MAX_PARALLEL; ++i)
+    {
+        if (expert.channels[i] == task_idx)
+        {
+            expert.channels[i] = -1;
+            expert.free_channel(env_tm);
+            break;
+        }
+    }
+}
+
+/**
+ * Generated tasks not assigned yet, queued by type and max response time in generate order, so the head of a queue has
+ * waited longest relative to its max response time among the tasks of the queue
+ */
+struct WaitingTasks
+{
+    std::vector<int> resps;                           // the distinct max response times
+    std::vector<std::vector<std::deque<int>>> queues; // task idxs of each type and max response time
+    std::vector<std::vector<int>> taken;              // tasks taken from the head of each queue by the last `top`
+    std::vector<int> sizes;                           // tasks waiting of each type
+
+    WaitingTasks(const std::vector<monte_utils::Task> &tasks) : sizes(monte_utils::NUM_TASK_TYPE, 0)
+    {
+        for (const monte_utils::Task &task : tasks)
+            resps.push_back(task.max_resp);
+        std::sort(resps.begin(), resps.end());
+        resps.erase(std::unique(resps.begin(), resps.end()), resps.end());
+        queues.assign(monte_utils::NUM_TASK_TYPE, std::vector<std::deque<int>>(resps.size()));
+        taken.assign(monte_utils::NUM_TASK_TYPE, std::vector<int>(resps.size(), 0));
+    }
+
+    bool empty(int type) const
+    {
+        return sizes[type] == 0;
+    }
+
+    void push(const std::vector<monte_utils::Task> &tasks, int task_idx)
+    {
+        const monte_utils::Task &task = tasks[task_idx];
+        int r = std::lower_bound(resps.begin(), resps.end(), task.max_resp) - resps.begin();
+        queues[task.type][r].push_back(task_idx);
+        sizes[task.type]++;
+    }
+
+    /**
+     * Append to `out` at most k tasks of the type which have waited longest relative to their max response time
+     */
+    void top(const std::vector<monte_utils::Task> &tasks, int type, int k, int env_tm, std::vector<int> &out)
+    {
+        std::vector<int> &pos = taken[type];
+        std::fill(pos.begin(), pos.end(), 0);
+        for (; k > 0; --k)
+        {
+            int best = -1;
+            double best_ratio = -1;
+            for (int r = 0; r < resps.size(); ++r)
+            {
+                if (pos[r] == queues[type][r].size())
+                    continue;
+                const monte_utils::Task &task = tasks[queues[type][r][pos[r]]];
+                double ratio = (env_tm - task.generate_tm + 1) * 1.0 / task.max_resp;
+                if (ratio > best_ratio)
+                {
+                    best_ratio = ratio;
+                    best = r;
+                }
+            }
+            if (best == -1)
+                break;
+            out.push_back(queues[type][best][pos[best]++]);
+        }
+    }
+
+    /**
+     * Drop the assigned tasks of the type, they are among the tasks taken by the last `top`
+     */
+    void remove_assigned(const std::vector<monte_utils::Task> &tasks, int type)
+    {
+        for (int r = 0; r < resps.size(); ++r)
+        {
+            std::deque<int> &queue = queues[type][r];
+            std::deque<int>::iterator end = queue.begin() + taken[type][r];
+            std::deque<int>::iterator kept = std::remove_if(queue.begin(), end,
+                                                            [&tasks](const int i) { return tasks[i].curr_migrate_count > 0; });
+            sizes[type] -= end - kept;
+            queue.erase(kept, end);
+            taken[type][r] = 0;
+        }
+    }
+};
+
+/**
+ * Min cost assignment of waiting tasks to idle channels, solved by the auction method in its benefit form.
+ * The benefit of assigning a task is its wait cost minus the assign cost and the channel price, waiting is always open
+ * to a task with benefit 0, so a task bids for a channel only while it gains more than waiting. Tasks of a type differ
+ * only in their wait cost, so of each type only the tasks waiting longest, as many as its idle channels, take part. Prices are kept across time slots as the warm start, a freed channel starts from
+ * the price its expert was last taken at, so tasks which can not afford it wait without a bidding war.
+ * A channel left unassigned above price 0 lowers its price by a reverse bid and takes the task gaining most from it,
+ * so the result is within AUCTION_EPS per task of the min cost
+ */
+struct BatchMatcher
+{
+    std::vector<double> expert_price;         // the price each expert's channels were last taken at
+    std::vector<std::vector<int>> type_chans; // idle channels of the experts suitable for each type
+    // scratch buffers reused by each time slot
+    std::vector<int> active_types, type_begin, type_end; // bidders of type t are [type_begin[t], type_end[t])
+    std::vector<int> bidders, bidder_chan, chan_expert, chan_owner, queue;
+    std::vector<double> bidder_wait_cost, chan_price, expert_cost;
+
+    BatchMatcher(int num_experts) : expert_price(num_experts, 0), type_chans(monte_utils::NUM_TASK_TYPE),
+                                    type_begin(monte_utils::NUM_TASK_TYPE), type_end(monte_utils::NUM_TASK_TYPE) {}
+
+    /**
+     * The longer a task has waited relative to its max response time, the more it costs to keep it waiting
+     */
+    double wait_cost(const monte_utils::Task &task, int env_tm) const
+    {
+        return WAIT_COST * (1 + (env_tm - task.generate_tm + 1) * 1.0 / task.max_resp);
+    }
+
+    /**
+     * Benefit of bidder b taking channel c for free, the assign cost is the processing time plus a workload balance term
+     */
+    double gain(const std::vector<monte_utils::Task> &tasks, const std::vector<monte_utils::Expert> &experts, int b, int c) const
+    {
+        int e = chan_expert[c];
+        return bidder_wait_cost[b] - experts[e].process_type_duras[tasks[bidders[b]].type] - expert_cost[e];
+    }
+
+    double value(const std::vector<monte_utils::Task> &tasks, const std::vector<monte_utils::Expert> &experts, int b, int c) const
+    {
+        return gain(tasks, experts, b, c) - chan_price[c];
+    }
+
+    /**
+     * Benefit bidder b currently holds, 0 if it waits
+     */
+    double held_value(const std::vector<monte_utils::Task> &tasks, const std::vector<monte_utils::Expert> &experts, int b) const
+    {
+        return bidder_chan[b] == -1 ? 0 : value(tasks, experts, b, bidder_chan[b]);
+    }
+
+    /**
+     * Forward bids, until every bidder holds a channel or waits, each within eps of its best choice
+     */
+    void run_auction(const std::vector<monte_utils::Task> &tasks, const std::vector<monte_utils::Expert> &experts, double eps)
+    {
+        while (!queue.empty())
+        {
+            int b = queue.back();
+            queue.pop_back();
+            double best = 0, second = 0; // waiting is worth 0
+            int best_chan = -1;
+            for (int c : type_chans[tasks[bidders[b]].type])
+            {
+                double val = value(tasks, experts, b, c);
+                if (val > best)
+                {
+                    second = best;
+                    best = val;
+                    best_chan = c;
+                }
+                else if (val > second)
+                    second = val;
+            }
+            bidder_chan[b] = best_chan;
+            if (best_chan == -1)
+                continue;
+            chan_price[best_chan] += best - second + eps;
+            if (chan_owner[best_chan] != -1)
+            {
+                bidder_chan[chan_owner[best_chan]] = -1;
+                queue.push_back(chan_owner[best_chan]);
+            }
+            chan_owner[best_chan] = b;
+        }
+    }
+
+    /**
+     * Reverse bids of the channels left unassigned above price 0, a channel takes the bidder gaining most from it over what
+     * the bidder holds, at the price leaving the second best no better off, or drops to price 0 if no bidder gains,
+     * a bidder leaving its channel leaves it for a reverse bid
+     */
+    void run_reverse_auction(const std::vector<monte_utils::Task> &tasks, const std::vector<monte_utils::Expert> &experts,
+                             const std::vector<std::vector<int>> &expert_types)
+    {
+        for (int c = 0; c < chan_owner.size(); ++c)
+        {
+            if (chan_owner[c] == -1 && chan_price[c] > 0)
+                queue.push_back(c);
+        }
+        while (!queue.empty())
+        {
+            int c = queue.back();
+            queue.pop_back();
+            double best = -HUGE_VAL, second = -HUGE_VAL;
+            int best_bidder = -1;
+            for (int t : expert_types[chan_expert[c]])
+            {
+                if (type_chans[t].empty())
+                    continue;
+                for (int b = type_begin[t]; b < type_end[t]; ++b)
+                {
+                    double val = gain(tasks, experts, b, c) - held_value(tasks, experts, b);
+                    if (val > best)
+                    {
+                        second = best;
+                        best = val;
+                        best_bidder = b;
+                    }
+                    else if (val > second)
+                        second = val;
+                }
+            }
+            if (best_bidder == -1 || best <= AUCTION_EPS)
+            {
+                chan_price[c] = 0;
+                continue;
+            }
+            chan_price[c] = std::max(0.0, second - AUCTION_EPS);
+            int prev = bidder_chan[best_bidder];
+            if (prev != -1)
+            {
+                chan_owner[prev] = -1;
+                if (chan_price[prev] > 0)
+                    queue.push_back(prev);
+            }
+            chan_owner[c] = best_bidder;
+            bidder_chan[best_bidder] = c;
+        }
+    }
+
+    /**
+     * @param waiting: tasks waiting to be assigned
+     * @param expert_types: the types each expert is suitable for
+     * @param matched: output, the pairs of task idx and expert idx assigned
+     */
+    void solve(const std::vector<monte_utils::Task> &tasks, const std::vector<monte_utils::Expert> &experts,
+               WaitingTasks &waiting, const std::vector<std::vector<int>> &expert_types,
+               std::vector<std::pair<int, int>> &matched, int env_tm)
+    {
+        matched.clear();
+        for (int t : active_types)
+            type_chans[t].clear();
+        active_types.clear();
+        chan_expert.clear();
+        chan_price.clear();
+        expert_cost.resize(experts.size());
+        for (int e = 0; e < experts.size(); ++e)
+        {
+            if (experts[e].num_idle_channel == 0)
+                continue;
+            bool wanted = false;
+            for (int t : expert_types[e])
+                wanted = wanted || !waiting.empty(t);
+            if (!wanted)
+                continue;
+            expert_cost[e] = BALANCE_WEIGHT * experts[e].busy_time(env_tm) / (env_tm + 1);
+            for (int k = 0; k < experts[e].num_idle_channel; ++k)
+            {
+                for (int t : expert_types[e])
+                {
+                    if (waiting.empty(t))
+                        continue;
+                    if (type_chans[t].empty())
+                        active_types.push_back(t);
+                    type_chans[t].push_back(chan_expert.size());
+                }
+                chan_expert.push_back(e);
+                chan_price.push_back(expert_price[e]);
+            }
+        }
+        int num_channels = chan_expert.size();
+        if (num_channels == 0)
+            return;
+        std::sort(active_types.begin(), active_types.end());
+        bidders.clear();
+        bidder_wait_cost.clear();
+        for (int t : active_types)
+        {
+            type_begin[t] = bidders.size();
+            waiting.top(tasks, t, type_chans[t].size(), env_tm, bidders);
+            type_end[t] = bidders.size();
+            for (int b = type_begin[t]; b < type_end[t]; ++b)
+                bidder_wait_cost.push_back(wait_cost(tasks[bidders[b]], env_tm));
+        }
+        int num_bidders = bidders.size();
+        // rounds of bids with smaller min raise, the coarse rounds settle the prices of identical channels of an expert
+        // without raising them by a tiny raise at a time
+        for (double eps = std::max(AUCTION_EPS_START, AUCTION_EPS);; eps = std::max(eps / AUCTION_EPS_DIV, AUCTION_EPS))
+        {
+            bidder_chan.assign(num_bidders, -1);
+            chan_owner.assign(num_channels, -1);
+            queue.resize(num_bidders);
+            for (int b = 0; b < num_bidders; ++b)
+                queue[b] = num_bidders - 1 - b; // taken from the back, so tasks waiting longer bid first
+            run_auction(tasks, experts, eps);
+            if (eps == AUCTION_EPS)
+                break;
+        }
+        run_reverse_auction(tasks, experts, expert_types);
+        for (int c = 0; c < num_channels; ++c)
+            expert_price[chan_expert[c]] = HUGE_VAL;
+        for (int c = 0; c < num_channels; ++c)
+        {
+            int e = chan_expert[c];
+            expert_price[e] = std::min(expert_price[e], chan_price[c]);
+            if (chan_owner[c] != -1)
+                matched.push_back(std::make_pair(bidders[chan_owner[c]], e));
+        }
+    }
+};
+
+/**
+ * At each time slot, finished tasks release their channels, then all generated tasks not assigned yet are matched
+ * with the idle channels of suitable experts together, tasks not matched wait for the next time slot
+ */
+std::tuple<std::vector<monte_utils::Assignment>, double> run_alg(std::vector<monte_utils::Task> tasks,
+                                                                 std::vector<monte_utils::Expert> experts)
+{
+    int num_finish = 0, env_tm = 0, num_generated = 0;
+    BatchMatcher matcher(experts.size());
+    std::vector<std::pair<int, int>> matched;
+    WaitingTasks waiting(tasks);
+    std::vector<std::vector<int>> expert_types(experts.size());
+    for (int e = 0; e < experts.size(); ++e)
+    {
+        for (int t = 0; t < monte_utils::NUM_TASK_TYPE; ++t)
+        {
+            if (experts[e].process_type_duras[t] != monte_utils::EXPERT_NOT_GOOD_TIME)
+                expert_types[e].push_back(t);
+        }
+    }
+    while (num_finish < tasks.size())
+    {
+        // check finish, only the tasks on expert channels can finish
+        for (int e = 0; e < experts.size(); ++e)
+        {
+            for (int k = 0; k < monte_utils::EXPERT_MAX_PARALLEL; ++k)
+            {
+                int i = experts[e].channels[k];
+                if (i == -1 || tasks[i].assign_tm[0] + experts[e].process_type_duras[tasks[i].type] != env_tm)
+                    continue;
+                release_task(experts[e], i, env_tm);
+                tasks[i].finish_tm = env_tm;
+                num_finish++;
+            }
+        }
+        // tasks are sorted by generate time
+        while (num_generated < tasks.size() && tasks[num_generated].generate_tm <= env_tm)
+        {
+            waiting.push(tasks, num_generated);
+            num_generated++;
+        }
+        matcher.solve(tasks, experts, waiting, expert_types, matched, env_tm);
+        for (const std::pair<int, int> &m : matched)
+            assign_task(tasks[m.first], experts[m.second], m.first, m.second, env_tm);
+        if (!matched.empty())
+        {
+            for (int t : matcher.active_types)
+                waiting.remove_assigned(tasks, t);
+        }
+        env_tm++;
+    }
+
+    std::vector<monte_utils::Assignment> solution = extract_result(tasks, experts);
+    double score = monte_metrics::score(tasks, experts);
+    return std::make_tuple(std::move(solution), score);
+}
+
+int main(int argc, char const *argv[])
+{
+    std::vector<monte_utils::Task> tasks = monte_utils::load_tasks();
+    std::vector<monte_utils::Expert> experts = monte_utils::load_experts();
+    std::sort(tasks.begin(), tasks.end(), [](const monte_utils::Task &a, const monte_utils::Task &b) -> bool {
+        if (a.generate_tm != b.generate_tm)
+            return a.generate_tm < b.generate_tm;
+        else
+            return a.task_id < b.task_id;
+    });
+    std::tuple<std::vector<monte_utils::Assignment>, double> ret = run_alg(tasks, experts);
+    printf("score=%lf\n", std::get<1>(ret));
+    save_result(std::move(std::get<0>(ret)), std::get<1>(ret));
+    return 0;
+}
@@ -0,0 +1,821 @@
+/**
+ * Monte Carlo Tree Search Algorithm
+ */
+
+#pragma once
+#include "best_board.hpp"
+#include "monte_metrics.hpp"
+#include "monte_utils.hpp"
+#include "logger.hpp"
+#include "profiler.hpp"
+#include "rand_utils.hpp"
+#include "shm_board.hpp"
+#include "thread_pool.hpp"
+#include <cstdint>
+
+namespace mcts
+{
+
+static best_board::BestBoard BEST_BOARD([](const best_board::Incumbent &inc) {
+    LOG_INFO("\tSimulation update best score=%lf", inc.score);
+    shm_board::global_board().push(inc.score, inc.solution);
+}); // the best result updated by rollout jobs
+static uint64_t MASTER_SEED = 0;
+static thread_local rand_utils::Xoshiro256 rng; // generator of the calling thread, rollout jobs draw from their own seeded one
+static const int FORCE_MIGRATE_MAX_EXEC = 1000; // if task has executed on a expert for more than the value, the task must be forced to migrate
+static const int MAX_EXPAND_CHILD = 8;
+static const int URGENT_THRESHOLD = 10;
+static const int ROLLOUT_EPSILON = 10; // percent of rollout decisions taken by random policy instead of SPT policy
+static const int MAX_SIMULATION_DEPTH = 10000;
+static const int NUM_SIMULATION = 8;
+static const int MAX_ITER = 10000;
+static const size_t TREE_MEM_BUDGET = (size_t)2 << 30; // bytes of node states kept by the search tree, least valuable leaf nodes are evicted beyond it
+static const int TRANS_TABLE_SIZE = 1 << 16;              // slots of transposition table, must be power of 2
+static const int TRANS_TABLE_PROBE = 4;                   // slots probed for each key
+
+/**
+ * splitmix64 finalizer, the zobrist keys are mixed on the fly from their components instead of a random key table
+ */
+static inline uint64_t zobrist_key(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+struct MCTNode;
+
+/**
+ * Bounded transposition table from state key to the tree node holding the state
+ * each key probes `TRANS_TABLE_PROBE` consecutive slots, when all are taken the home slot is replaced
+ */
+struct TransTable
+{
+    uint64_t keys[TRANS_TABLE_SIZE];
+    MCTNode *nodes[TRANS_TABLE_SIZE];
+
+    TransTable()
+    {
+        std::fill(keys, keys + TRANS_TABLE_SIZE, 0);
+        std::fill(nodes, nodes + TRANS_TABLE_SIZE, nullptr);
+    }
+
+    MCTNode *find(uint64_t key)
+    {
+        for (int i = 0; i < TRANS_TABLE_PROBE; ++i)
+        {
+            int slot = (key + i) & (TRANS_TABLE_SIZE - 1);
+            if (nodes[slot] && keys[slot] == key)
+                return nodes[slot];
+        }
+        return nullptr;
+    }
+
+    void insert(uint64_t key, MCTNode *node)
+    {
+        int home = key & (TRANS_TABLE_SIZE - 1), slot = home;
+        for (int i = 0; i < TRANS_TABLE_PROBE; ++i)
+        {
+            if (!nodes[(key + i) & (TRANS_TABLE_SIZE - 1)])
+            {
+                slot = (key + i) & (TRANS_TABLE_SIZE - 1);
+                break;
+            }
+        }
+        keys[slot] = key;
+        nodes[slot] = node;
+    }
+
+    void erase(uint64_t key, MCTNode *node)
+    {
+        for (int i = 0; i < TRANS_TABLE_PROBE; ++i)
+        {
+            int slot = (key + i) & (TRANS_TABLE_SIZE - 1);
+            if (nodes[slot] == node)
+                nodes[slot] = nullptr;
+        }
+    }
+};
+
+static TransTable TRANS_TABLE;
+
+struct MCTNode
+{
+    int env_tm;
+    int num_sim;
+    double reward_sum;
+    int num_finish_tasks;
+    MCTNode *parent;
+    std::vector<monte_utils::Task> tasks;
+    std::vector<monte_utils::Expert> experts;
+    MCTNode *child_nodes[MAX_EXPAND_CHILD];
+    int child_node_count = 0;
+    int last_visit_iter; // the latest iteration the node is expanded or simulated, used for evicting stale nodes
+    monte_utils::IdleExperts idle_experts;
+    uint64_t state_hash; // zobrist hash of the assignments history and the tasks occupying expert channels
+
+    MCTNode() : env_tm(0), num_sim(0), reward_sum(0), num_finish_tasks(0), parent(nullptr), child_node_count(0), last_visit_iter(0),
+                state_hash(0)
+    {
+        for (int i = 0; i < MAX_EXPAND_CHILD; ++i)
+            child_nodes[i] = nullptr;
+    }
+
+    ~MCTNode()
+    {
+        TRANS_TABLE.erase(this->trans_key(), this);
+        parent = nullptr;
+        for (int i = 0; i < MAX_EXPAND_CHILD; ++i)
+            child_nodes[i] = nullptr;
+    }
+
+    MCTNode &operator=(const MCTNode &node)
+    {
+        if (this != &node)
+        {
+            this->env_tm = node.env_tm;
+            this->num_sim = node.num_sim;
+            this->reward_sum = node.reward_sum;
+            this->num_finish_tasks = node.num_finish_tasks;
+            this->parent = node.parent;
+            this->clear_child_nodes(); // the copied node starts as a leaf, child links are not shared
+            this->last_visit_iter = node.last_visit_iter;
+            this->state_hash = node.state_hash;
+
+            this->tasks.resize(node.tasks.size());
+            for (int i = 0; i < node.tasks.size(); ++i)
+                this->tasks[i] = node.tasks[i];
+            this->experts.resize(node.experts.size());
+            for (int i = 0; i < node.experts.size(); ++i)
+                this->experts[i] = node.experts[i];
+            this->idle_experts = node.idle_experts;
+        }
+        return *this;
+    }
+
+    void add_child(MCTNode *node)
+    {
+        this->child_nodes[this->child_node_count++] = node;
+    }
+
+    void remove_last_child()
+    {
+        this->child_nodes[--this->child_node_count] = nullptr;
+    }
+
+    void remove_free_last_child()
+    {
+        MCTNode *p = this->child_nodes[--this->child_node_count];
+        this->child_nodes[this->child_node_count] = nullptr;
+        delete p;
+    }
+
+    void clear_child_nodes()
+    {
+        for (int i = 0; i < this->child_node_count; ++i)
+            this->child_nodes[i] = nullptr;
+        this->child_node_count = 0;
+    }
+
+    void clear_free_child_nodes()
+    {
+        for (int i = 0; i < this->child_node_count; ++i)
+        {
+            delete this->child_nodes[i];
+            this->child_nodes[i] = nullptr;
+        }
+        this->child_node_count = 0;
+    }
+
+    /**
+     * only remove child node from this node's child_nodes array, not free it
+     */
+    void remove_child(MCTNode *node)
+    {
+        for (int i = 0; i < this->child_node_count; ++i)
+        {
+            if (this->child_nodes[i] == node)
+            {
+                this->child_nodes[i] = this->child_nodes[--this->child_node_count];
+                this->child_nodes[this->child_node_count] = nullptr;
+                break;
+            }
+        }
+    }
+
+    /**
+     * After expanded, the node only keeps statistics, the states of tasks and experts are released
+     */
+    void release_state()
+    {
+        std::vector<monte_utils::Task>().swap(this->tasks);
+        std::vector<monte_utils::Expert>().swap(this->experts);
+        this->idle_experts = monte_utils::IdleExperts();
+    }
+
+    /**
+     * Same states reached at same time by different action orders have the same key
+     */
+    uint64_t trans_key() const
+    {
+        return this->state_hash ^ zobrist_key(this->env_tm);
+    }
+
+    size_t state_bytes() const
+    {
+        return sizeof(MCTNode) + this->tasks.capacity() * sizeof(monte_utils::Task) +
+               this->experts.capacity() * sizeof(monte_utils::Expert) +
+               (this->idle_experts.all_idle.capacity() + this->idle_experts.all_pos.capacity() +
+                this->idle_experts.group_idle.capacity() + this->idle_experts.group_pos.capacity()) *
+                   sizeof(int);
+    }
+};
+
+MCTNode *init_root(std::vector<monte_utils::Task> &tasks, std::vector<monte_utils::Expert> &expts,
+                   std::vector<std::vector<int>> &expert_groups)
+{
+    MCTNode *root = new MCTNode();
+    root->tasks.resize(tasks.size());
+    for (int i = 0; i < root->tasks.size(); ++i)
+        root->tasks[i] = tasks[i];
+    root->experts.resize(expts.size());
+    for (int i = 0; i < root->experts.size(); ++i)
+        root->experts[i] = expts[i];
+    root->idle_experts.init(expert_groups, expts.size());
+    return root;
+}
+
+std::vector<std::vector<int>> group_expert_by_type(std::vector<monte_utils::Expert> &experts, int num_types)
+{
+    PROFILE_SCOPE(profiler::GROUP_EXPERTS);
+    std::vector<std::vector<int>> expert_groups(num_types);
+    for (int i = 0; i < experts.size(); ++i)
+    {
+        for (int j = 0; j < num_types; ++j)
+        {
+            if (experts[i].process_type_duras[j] < monte_utils::EXPERT_NOT_GOOD_TIME)
+                expert_groups[j].push_back(i);
+        }
+    }
+    return expert_groups;
+}
+
+/**
+ * uniform random integer in [0, n)
+ */
+int rand_below(int n)
+{
+    return rand_utils::below(rng, n);
+}
+
+/**
+ * Zobrist key of the task occupying a channel of the expert
+ */
+uint64_t channel_key(int task_idx, int expt_idx)
+{
+    return zobrist_key(((uint64_t)task_idx << 32) | (uint32_t)expt_idx);
+}
+
+/**
+ * Zobrist key of the `k`th assignment record of the task
+ */
+uint64_t assign_key(int task_idx, int k, int expt_idx, int assign_tm)
+{
+    return zobrist_key(zobrist_key(((uint64_t)(task_idx * monte_utils::TASK_MAX_MIGRATION + k) << 32) | (uint32_t)expt_idx) ^ (uint32_t)assign_tm);
+}
+
+/**
+ * Release task from the channel of expert, the expert turns idle
+ */
+void release_task_from_expert(MCTNode *node, int task_idx, int expt_idx, int env_tm)
+{
+    monte_utils::Expert &expert = node->experts[expt_idx];
+    for (int i = 0; i < monte_utils::EXPERT_MAX_PARALLEL; ++i)
+    {
+        if (expert.channels[i] == task_idx)
+        {
+            expert.channels[i] = -1;
+            expert.free_channel(env_tm);
+            node->idle_experts.mark_idle(expt_idx, expert.process_type_duras);
+            node->state_hash ^= channel_key(task_idx, expt_idx);
+            break;
+        }
+    }
+}
+
+/**
+ * Assign task to an idle channel of expert, if the task is executing on another expert, it migrates
+ */
+bool assign_task_to_expert(MCTNode *node, int task_idx, int expt_idx, int env_tm)
+{
+    monte_utils::Task &task = node->tasks[task_idx];
+    monte_utils::Expert &expert = node->experts[expt_idx];
+    if (expert.num_idle_channel <= 0)
+        return false;
+    if (task.curr_migrate_count > 0)
+        release_task_from_expert(node, task_idx, task.each_stay_expert_id[task.curr_migrate_count - 1], env_tm);
+    if (task.start_process_tm == -1)
+        task.start_process_tm = env_tm;
+    task.assign_tm[task.curr_migrate_count] = env_tm;
+    task.each_stay_expert_id[task.curr_migrate_count] = expt_idx;
+    node->state_hash ^= assign_key(task_idx, task.curr_migrate_count, expt_idx, env_tm) ^ channel_key(task_idx, expt_idx);
+    task.curr_migrate_count++;
+    for (int i = 0; i < monte_utils::EXPERT_MAX_PARALLEL; ++i)
+    {
+        if (expert.channels[i] == -1)
+        {
+            expert.channels[i] = task_idx;
+            expert.take_channel(env_tm);
+            break;
+        }
+    }
+    if (expert.num_idle_channel == 0)
+        node->idle_experts.mark_full(expt_idx, expert.process_type_duras);
+    return true;
+}
+
+/**
+ * the expert the task currently executing on, -1 if not assigned yet
+ */
+int curr_expert_of(monte_utils::Task &task)
+{
+    return task.curr_migrate_count > 0 ? task.each_stay_expert_id[task.curr_migrate_count - 1] : -1;
+}
+
+/**
+ * Try to assign current task to a uniformly sampled idle suitable expert, if no suitable expert availble
+ * then to a uniformly sampled idle expert, return false immediately if no expert has idle channel
+ */
+bool try_assign_suit_expert(MCTNode *node, int env_tm, int selected_task_idx)
+{
+    monte_utils::Task &task = node->tasks[selected_task_idx];
+    int prev_expt_idx = curr_expert_of(task);
+    int expt_idx = node->idle_experts.sample(rand_below, task.type, prev_expt_idx);
+    if (expt_idx == -1)
+        expt_idx = node->idle_experts.sample(rand_below, -1, prev_expt_idx);
+    if (expt_idx == -1)
+        return false;
+    return assign_task_to_expert(node, selected_task_idx, expt_idx, env_tm);
+}
+
+/**
+ * This function is little bit different from `try_assign_suit_expert`
+ * this function only samples from idle suitable experts, and the task will wait if none
+ */
+bool try_assign_suit_or_wait(MCTNode *node, int env_tm, int selected_task_idx)
+{
+    monte_utils::Task &task = node->tasks[selected_task_idx];
+    int expt_idx = node->idle_experts.sample(rand_below, task.type, curr_expert_of(task));
+    if (expt_idx == -1)
+        return false;
+    return assign_task_to_expert(node, selected_task_idx, expt_idx, env_tm);
+}
+
+void try_continue_exec_or_migrate(MCTNode *node, int env_tm, int selected_task_idx, bool force_next_suit, int favor_epsilon)
+{
+    int favor_value = rand_utils::range(rng, 1, 100);
+    monte_utils::Task *task = &node->tasks[selected_task_idx];
+    int prev_expt_idx = task->each_stay_expert_id[task->curr_migrate_count - 1];
+    bool is_migration = false;
+    if (node->experts[prev_expt_idx].process_type_duras[task->type] == monte_utils::EXPERT_NOT_GOOD_TIME)
+    {
+        // favor migration
+        if (favor_value > favor_epsilon)
+        {
+            // migration
+            is_migration = true;
+        }
+    }
+    else
+    {
+        // current expert is suitable, favor continuing executing
+        if (favor_value <= favor_epsilon)
+        {
+            // migration
+            is_migration = true;
+        }
+    }
+
+    if (is_migration)
+    {
+        if (force_next_suit)
+        {
+            //  the next assigned expert must be suitable, if no avail, not migrate
+            try_assign_suit_or_wait(node, env_tm, selected_task_idx);
+        }
+        else
+        {
+            // next assigned expert can be not suitable
+            try_assign_suit_expert(node, env_tm, selected_task_idx);
+        }
+    }
+    task = nullptr;
+}
+
+/**
+ * check whether exist task finish and update record varialbes
+ */
+void update(MCTNode *node)
+{
+    for (int i = 0; i < node->tasks.size(); ++i)
+    {
+        if (node->tasks[i].curr_migrate_count == 0)
+            continue;
+        int task_due_time =
+            node->experts[node->tasks[i].each_stay_expert_id[node->tasks[i].curr_migrate_count - 1]].process_type_duras[node->tasks[i].type] +
+            node->tasks[i].assign_tm[node->tasks[i].curr_migrate_count - 1];
+        if (task_due_time == node->env_tm)
+        {
+            // task finish
+            node->num_finish_tasks++;
+            node->tasks[i].finish_tm = node->env_tm;
+            int expt_idx = node->tasks[i].each_stay_expert_id[node->tasks[i].curr_migrate_count - 1];
+            // the expert is still busy during the finishing slot
+            release_task_from_expert(node, i, expt_idx, node->env_tm + 1);
+        }
+    }
+}
+
+/**
+ * Rollout policies decide the action of one task at one time slot, each policy provides
+ *  `static void act(MCTNode *node, int env_tm, int task_idx)`
+ * and is passed as template parameter of `expand`, `simulate` and `run_alg`, so that the policy calls are
+ * inlined into the rollout loop
+ */
+
+/**
+ * Random policy, the task not assigned yet favors suitable experts and is forced to assign when urgent,
+ * the assigned task favors continuing on suitable expert and migrating away from not suitable expert
+ */
+struct RandomRolloutPolicy
+{
+    static const int FAVOR_EPSILON = 30; // percent of taking the not favored choice between continuing and migration
+
+    static inline void act(MCTNode *node, int env_tm, int task_idx)
+    {
+        monte_utils::Task &task = node->tasks[task_idx];
+        // possible actions
+        // if the task has not been assigned before, the task can choose wait or assign to an expert
+        // the choice should depend on whther the task will soon timeout
+        // if the task has been assigned, then it can choose continuing executing or migration
+        // max migration restrict and whether the expert is suitable should be considered
+        if (task.curr_migrate_count == 0)
+        {
+            // not assigned yet, wait or assign
+            if (task.generate_tm + task.max_resp - env_tm < URGENT_THRESHOLD)
+            {
+                // urgent, force assign if experts available, favor suitable expert
+                try_assign_suit_expert(node, env_tm, task_idx);
+            }
+            else
+            {
+                // not urgent, random choose, but favor assign
+                try_assign_suit_or_wait(node, env_tm, task_idx);
+            }
+        }
+        else if (task.curr_migrate_count + 1 == monte_utils::TASK_MAX_MIGRATION)
+        {
+            // if current assigned expert is suitable, favor continue execution, not favor migration
+            // if not suitable, favor migration, but the last expert must be suitable
+            try_continue_exec_or_migrate(node, env_tm, task_idx, true, FAVOR_EPSILON);
+        }
+        else if (task.curr_migrate_count + 1 < monte_utils::TASK_MAX_MIGRATION)
+        {
+            // if current assigned expert is suitable, favor continue execution, not favor migration
+            // if not suitable, favor migration, but favor suit experts
+            try_continue_exec_or_migrate(node, env_tm, task_idx, false, FAVOR_EPSILON);
+        }
+    }
+};
+
+/**
+ * Greedy SPT policy, same order as `spt_run`: the idle suitable expert with shortest processing time is chosen,
+ * ties are broken by less busy time, more idle channels and expert id.
+ * The task not assigned yet waits if no suitable expert idle, unless it is urgent, then any idle expert is taken,
+ * the task on not suitable expert migrates as soon as a suitable expert idle, the task on suitable expert continues
+ */
+struct SPTRolloutPolicy
+{
+    static inline int best_idle_suit_expert(MCTNode *node, int type)
+    {
+        const int *idle = node->idle_experts.idle_list(type);
+        int num_idle = node->idle_experts.num_idle(type), best = -1;
+        for (int i = 0; i < num_idle; ++i)
+        {
+            const monte_utils::Expert &a = node->experts[idle[i]];
+            if (best != -1)
+            {
+                const monte_utils::Expert &b = node->experts[best];
+                if (a.process_type_duras[type] != b.process_type_duras[type])
+                {
+                    if (a.process_type_duras[type] > b.process_type_duras[type])
+                        continue;
+                }
+                else if (a.busy_time(node->env_tm) != b.busy_time(node->env_tm))
+                {
+                    if (a.busy_time(node->env_tm) > b.busy_time(node->env_tm))
+                        continue;
+                }
+                else if (a.num_idle_channel != b.num_idle_channel)
+                {
+                    if (a.num_idle_channel < b.num_idle_channel)
+                        continue;
+                }
+                else if (a.expert_id > b.expert_id)
+                    continue;
+            }
+            best = idle[i];
+        }
+        return best;
+    }
+
+    static inline void act(MCTNode *node, int env_tm, int task_idx)
+    {
+        monte_utils::Task &task = node->tasks[task_idx];
+        if (task.curr_migrate_count == 0)
+        {
+            int expt_idx = best_idle_suit_expert(node, task.type);
+            if (expt_idx == -1 && task.generate_tm + task.max_resp - env_tm < URGENT_THRESHOLD)
+                expt_idx = node->idle_experts.sample(rand_below);
+            if (expt_idx != -1)
+                assign_task_to_expert(node, task_idx, expt_idx, env_tm);
+        }
+        else if (task.curr_migrate_count < monte_utils::TASK_MAX_MIGRATION &&
+                 node->experts[curr_expert_of(task)].process_type_duras[task.type] == monte_utils::EXPERT_NOT_GOOD_TIME)
+        {
+            int expt_idx = best_idle_suit_expert(node, task.type);
+            if (expt_idx != -1)
+                assign_task_to_expert(node, task_idx, expt_idx, env_tm);
+        }
+    }
+};
+
+/**
+ * Epsilon mixed policy, each decision is taken by `ExplorePolicy` with `EPSILON_PERCENT` percent, else by `ExploitPolicy`
+ */
+template <int EPSILON_PERCENT, typename ExploitPolicy = SPTRolloutPolicy, typename ExplorePolicy = RandomRolloutPolicy>
+struct EpsilonRolloutPolicy
+{
+    static inline void act(MCTNode *node, int env_tm, int task_idx)
+    {
+        if (rand_utils::range(rng, 1, 100) <= EPSILON_PERCENT)
+            ExplorePolicy::act(node, env_tm, task_idx);
+        else
+            ExploitPolicy::act(node, env_tm, task_idx);
+    }
+};
+
+typedef EpsilonRolloutPolicy<ROLLOUT_EPSILON> DefaultRolloutPolicy;
+
+/**
+ * The expand operation during Monte Carlo Tree Search
+ * each task generated and not finished takes an action decided by `Policy`
+ */
+template <typename Policy = RandomRolloutPolicy>
+bool expand(MCTNode *root, int num_expand = MAX_EXPAND_CHILD)
+{
+    int env_tm = root->env_tm + 1;
+    for (int ex = 0; ex < num_expand; ++ex)
+    {
+        MCTNode *child = new MCTNode();
+        *child = *root;
+        update(child);
+        child->env_tm = env_tm;
+        child->parent = root;
+        root->add_child(child);
+        for (int selected_task_idx = 0; selected_task_idx < child->tasks.size(); ++selected_task_idx)
+        {
+            if (child->tasks[selected_task_idx].finish_tm > 0 || child->tasks[selected_task_idx].generate_tm > env_tm)
+                continue;
+            Policy::act(child, env_tm, selected_task_idx);
+        }
+    }
+    return true;
+}
+
+/**
+ * Extract solution from the node, each row is task id, expert id and time
+ */
+std::vector<monte_utils::Assignment> extract_solution(MCTNode *node)
+{
+    std::vector<monte_utils::Assignment> solution;
+    solution.reserve(node->tasks.size());
+    for (int i = 0; i < node->tasks.size(); ++i)
+    {
+        for (int j = 0; j < node->tasks[i].curr_migrate_count; ++j)
+        {
+            solution.push_back({node->tasks[i].task_id, node->experts[node->tasks[i].each_stay_expert_id[j]].expert_id,
+                                node->tasks[i].assign_tm[j]});
+        }
+    }
+    return solution;
+}
+
+/**
+ * The simulation procedure of Monte Carlo Tree Search start from node, actions are decided by `RolloutPolicy`
+ */
+template <typename RolloutPolicy>
+void simulate(MCTNode *node)
+{
+    PROFILE_SCOPE(profiler::MCTS_ROLLOUT);
+    PROFILE_COUNT(profiler::ROLLOUTS, 1);
+    MCTNode *p = node;
+    int num_tasks = node->tasks.size();
+    int simu_depth = 0;
+    LOG_DEBUG("\tSimulation start...");
+    while (p->num_finish_tasks < num_tasks)
+    {
+        expand<RolloutPolicy>(p, 1);
+        MCTNode *q = p;
+        p = p->child_nodes[0];
+        q->remove_last_child(); // simulation nodes are not kept in the tree
+        if (q != node)
+        {
+            delete q;
+            q = nullptr;
+        }
+        if (simu_depth++ == MAX_SIMULATION_DEPTH)
+            break;
+        if (simu_depth % 10 == 0)
+            LOG_DEBUG("\t\tSimulation depth reach %d, num tasks finish=%d", simu_depth, p->num_finish_tasks);
+    }
+    LOG_DEBUG("\tSimulation finish...");
+    if (p->num_finish_tasks == num_tasks)
+    {
+        // finish all tasks, calculating reward
+        double score = monte_metrics::score(p->tasks, p->experts);
+        node->reward_sum += score;
+        node->num_sim++;
+        LOG_DEBUG("\tSimulation reach finish state, reward accumulate=%lf", node->reward_sum);
+        BEST_BOARD.offer(score, [p]() { return extract_solution(p); });
+    }
+    if (p != node)
+    {
+        delete p;
+        p = nullptr;
+    }
+}
+/**
+ * Remove the expanded children whose state is already held by another tree node, the state reached by
+ * different action orders is only expanded and simulated once, others are added into transposition table
+ */
+void merge_transposed_child_nodes(MCTNode *node)
+{
+    for (int i = node->child_node_count - 1; i >= 0; --i)
+    {
+        MCTNode *child = node->child_nodes[i];
+        MCTNode *same = TRANS_TABLE.find(child->trans_key());
+        if (same != nullptr && same != child && same->env_tm == child->env_tm)
+        {
+            node->remove_child(child);
+            delete child;
+        }
+        else
+            TRANS_TABLE.insert(child->trans_key(), child);
+    }
+}
+
+/**
+ * Free the node without children, the statistics are accumulated on its parent,
+ * and the parent left without children is freed in the same way
+ */
+void free_dead_branch(MCTNode *p)
+{
+    while (p->child_node_count == 0 && p->parent != nullptr)
+    {
+        MCTNode *parent = p->parent;
+        parent->reward_sum += p->reward_sum;
+        parent->num_sim += p->num_sim;
+        parent->remove_child(p);
+        delete p;
+        p = parent;
+    }
+}
+
+/**
+ * Evict the least valuable leaf nodes until the kept leaf nodes fit in the budget
+ * leaf nodes with less simulations are evicted first, ties are broken by the stalest visit,
+ * the statistics of evicted nodes are accumulated on their parents, and a parent left without
+ * children is evicted in the same way
+ */
+void evict_leaf_nodes(std::vector<MCTNode *> &leaf_nodes, int max_leaf_nodes)
+{
+    if (leaf_nodes.size() <= max_leaf_nodes)
+        return;
+    int num_evict = (int)leaf_nodes.size() - max_leaf_nodes;
+    std::nth_element(leaf_nodes.begin(), leaf_nodes.begin() + num_evict, leaf_nodes.end(), [](const MCTNode *a, const MCTNode *b) -> bool {
+        if (a->num_sim != b->num_sim)
+            return a->num_sim < b->num_sim;
+        else if (a->last_visit_iter != b->last_visit_iter)
+            return a->last_visit_iter < b->last_visit_iter;
+        else
+            return a->reward_sum < b->reward_sum;
+    });
+    for (int i = 0; i < num_evict; ++i)
+        free_dead_branch(leaf_nodes[i]);
+    leaf_nodes.erase(leaf_nodes.begin(), leaf_nodes.begin() + num_evict);
+}
+
+/**
+ * Remove the expanded children whose optimistic score bound can not beat the best score found so far
+ * @return true if any child is left
+ */
+bool prune_child_nodes(MCTNode *node, const std::vector<int> &max_duras)
+{
+    for (int i = node->child_node_count - 1; i >= 0; --i)
+    {
+        MCTNode *child = node->child_nodes[i];
+        if (monte_metrics::score_upper_bound(child->tasks, child->experts, child->env_tm, max_duras) <= BEST_BOARD.score())
+        {
+            node->remove_child(child);
+            delete child;
+        }
+    }
+    return node->child_node_count > 0;
+}
+
+/**
+ * Monte Carlo Tree Search algorithm method
+ * The algorithm contains four basic operations:
+ *  1. Expansion, at the beginning of each iteration, the algorithm need to select the best leaf node so far to expand new child nodes
+ *              At the initial state only root state, the expand operations is executed on root node
+ *  2. Simulation, after expand some child nodes, the algorithm will simulate many times from the child node till the terminal state
+ *  3. Backpropagate, when a simulation process reached the terminal state, the score will be calculated, if score is better than
+ *              the best score so far, the score and the whole transition will be recorded.
+ *  4. Selection, at the very initial state, the only choice is the root node, and after the above procedures, the best leaf node will be
+ *              selected for next iteration
+ * The tree nodes are expanded by random policy, and simulations are rolled out by `RolloutPolicy`
+ * Expanded nodes only keep statistics, and when the states kept by leaf nodes exceed `TREE_MEM_BUDGET`,
+ * the least valuable leaf nodes are evicted
+ * Expanded children which can not beat the best score found so far by `score_upper_bound` are pruned without simulation,
+ * the best score includes the incumbent of other processes with a shared memory board,
+ * and children whose state is already in the tree are merged by transposition table
+ */
+template <typename RolloutPolicy = DefaultRolloutPolicy>
+void run_alg(MCTNode *root, const std::vector<int> &max_duras)
+{
+    std::vector<MCTNode *> leaf_nodes;
+    leaf_nodes.push_back(root);
+    TRANS_TABLE.insert(root->trans_key(), root);
+    int max_leaf_nodes = std::max((int)(TREE_MEM_BUDGET / root->state_bytes()), MAX_EXPAND_CHILD + 1);
+    LOG_INFO("Start Monte Carlo Tree Search...");
+    for (int iter = 0; iter < MAX_ITER && !leaf_nodes.empty(); ++iter)
+    {
+        LOG_INFO("Alg iter#%d:", iter);
+        PROFILE_LAPS(laps);
+        PROFILE_LAP(laps, profiler::MCTS_SELECT);
+        MCTNode *best_leaf = leaf_nodes[0];
+        for (int i = 0; i < leaf_nodes.size(); ++i)
+        {
+            if (leaf_nodes[i]->reward_sum / (leaf_nodes[i]->num_sim + __DBL_EPSILON__) >
+                best_leaf->reward_sum / (best_leaf->num_sim + __DBL_EPSILON__))
+                best_leaf = leaf_nodes[i];
+        }
+        for (int i = 0; i < leaf_nodes.size(); ++i)
+        {
+            if (leaf_nodes[i] == best_leaf)
+            {
+                leaf_nodes.erase(leaf_nodes.begin() + i);
+                break;
+            }
+        }
+        LOG_DEBUG("Expand best leaf node...");
+        PROFILE_LAP(laps, profiler::MCTS_EXPAND);
+        shm_board::global_board().sync(BEST_BOARD);
+        expand(best_leaf);
+        merge_transposed_child_nodes(best_leaf);
+        if (!prune_child_nodes(best_leaf, max_duras))
+        {
+            LOG_DEBUG("All expanded child nodes pruned...");
+            PROFILE_LAP(laps, profiler::MCTS_EVICT);
+            best_leaf->release_state();
+            free_dead_branch(best_leaf);
+            continue;
+        }
+        for (int i = 0; i < best_leaf->child_node_count; ++i)
+        {
+            best_leaf->child_nodes[i]->last_visit_iter = iter;
+            leaf_nodes.push_back(best_leaf->child_nodes[i]);
+        }
+
+        PROFILE_LAP_END(laps);
+        LOG_DEBUG("Simulate from expanded child nodes...");
+        // the rollouts of each child are a job of the pool, jobs of different children share no node,
+        // the generator of the job is seeded by (iter, child), and the thread's own generator is restored after
+        thread_pool::global_pool().parallel_for(best_leaf->child_node_count, [&](const int j) {
+            rand_utils::Xoshiro256 thread_rng = rng;
+            rng = rand_utils::job_stream(MASTER_SEED, (uint64_t)iter * MAX_EXPAND_CHILD + j);
+            for (int i = 0; i < NUM_SIMULATION; ++i)
+                simulate<RolloutPolicy>(best_leaf->child_nodes[j]);
+            rng = thread_rng;
+        });
+        // best leaf node becomes inner node, only statistics kept
+        PROFILE_LAP(laps, profiler::MCTS_EVICT);
+        best_leaf->release_state();
+        best_leaf = nullptr;
+        evict_leaf_nodes(leaf_nodes, max_leaf_nodes);
+    }
+}
+
+} // namespace mcts
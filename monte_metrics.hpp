@@ -28,6 +28,8 @@ double task_exec_eff(monte_utils::Task &task)
 
 double score(std::vector<monte_utils::Task> &tasks, std::vector<monte_utils::Expert> &experts)
 {
+    PROFILE_SCOPE(profiler::SCORE);
+    PROFILE_COUNT(profiler::EVALUATIONS, 1);
     double avg_exec_eff = 0, avg_timeout = 0;
     for (int i = 0; i < tasks.size(); ++i)
     {
@@ -50,4 +52,64 @@ double score(std::vector<monte_utils::Task> &tasks, std::vector<monte_utils::Exp
     return 3000 * avg_exec_eff / (3 * avg_timeout + 2 * workload_std);
 }
 
+/**
+ * The longest processing time of the suitable experts for each type, used by `score_upper_bound`
+ */
+std::vector<int> suit_max_duras(std::vector<monte_utils::Expert> &experts, int num_types = monte_utils::NUM_TASK_TYPE)
+{
+    std::vector<int> max_duras(num_types, 0);
+    for (int i = 0; i < experts.size(); ++i)
+    {
+        for (int j = 0; j < num_types; ++j)
+        {
+            if (experts[i].process_type_duras[j] < monte_utils::EXPERT_NOT_GOOD_TIME)
+                max_duras[j] = std::max(max_duras[j], experts[i].process_type_duras[j]);
+        }
+    }
+    return max_duras;
+}
+
+/**
+ * Optimistic bound of the final `score` from an intermediate state at `env_tm`, the final score can not exceed it
+ * the timeouts of started tasks and the execution efficiency of finished tasks are fixed,
+ * tasks not started yet are assumed to start at `env_tm`, unfinished tasks are assumed to finish on the current expert
+ * or on the suitable expert with longest processing time after migrating at `env_tm`, whichever is more efficient,
+ * and the workload std is assumed to be 0, so the bound is infinite while no timeout is incurred
+ */
+double score_upper_bound(std::vector<monte_utils::Task> &tasks, std::vector<monte_utils::Expert> &experts, int env_tm,
+                         const std::vector<int> &max_duras)
+{
+    double sum_exec_eff = 0, sum_timeout = 0;
+    for (int i = 0; i < tasks.size(); ++i)
+    {
+        monte_utils::Task &task = tasks[i];
+        if (task.finish_tm != -1)
+        {
+            sum_exec_eff += task_exec_eff(task);
+            sum_timeout += task_timeout(task);
+            continue;
+        }
+        if (task.start_process_tm != -1)
+            sum_timeout += task_timeout(task);
+        else
+            sum_timeout += std::max(env_tm - task.generate_tm - task.max_resp, 0) * 1.0 / task.max_resp;
+        // the efficiency of migrating to a suitable expert at env_tm or later
+        int dura = max_duras[task.type];
+        double best_eff = task.curr_migrate_count < monte_utils::TASK_MAX_MIGRATION
+                              ? dura * 1.0 / (std::max(env_tm - task.generate_tm, 0) + dura)
+                              : 0;
+        if (task.curr_migrate_count > 0)
+        {
+            // the efficiency of continuing on current expert till finish
+            int assign_tm = task.assign_tm[task.curr_migrate_count - 1];
+            int curr_dura = experts[task.each_stay_expert_id[task.curr_migrate_count - 1]].process_type_duras[task.type];
+            best_eff = std::max(best_eff, curr_dura * 1.0 / (assign_tm + curr_dura - task.generate_tm));
+        }
+        sum_exec_eff += best_eff;
+    }
+    if (sum_timeout <= 0)
+        return HUGE_VAL;
+    return 3000 * sum_exec_eff / (3 * sum_timeout);
+}
+
 } // namespace monte_metrics
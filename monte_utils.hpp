@@ -2,11 +2,18 @@
  * This file contains utils for monte carlo method
  */
 #pragma once
+#include "profiler.hpp"
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <string>
 #include <vector>
 
+#ifndef TASK_TYPES
+#define TASK_TYPES 107 // types of the competition instance, build with -DTASK_TYPES=<n> for generated instances of n types
+#endif
+
 namespace monte_utils
 {
 const static char WORK_ORDER[100] = "../data/SIC_round1_testA_20200909/work_order.csv";
@@ -16,7 +23,7 @@ size_t PROCESS_TM_FILE_LINE_MAXLEN = 1000;
 const static int EXPERT_MAX_PARALLEL = 3;
 const static int EXPERT_NOT_GOOD_TIME = 999999; // If expert not good at some type tasks, the processing time will be 999999
 const static int TASK_MAX_MIGRATION = 5;
-const static int NUM_TASK_TYPE = 107;
+const static int NUM_TASK_TYPE = TASK_TYPES;
 
 struct Task
 {
@@ -83,9 +90,10 @@ struct Expert
     int process_type_duras[NUM_TASK_TYPE];
 
     int num_idle_channel;
-    int busy_sum; // the time long of processing takss from system begin to end
+    int busy_sum;   // the time long of processing takss from system begin to end, settled when the expert turns idle
+    int busy_since; // the time the expert last turned from idle to busy, -1 while idle
 
-    Expert() : expert_id(-1), num_idle_channel(EXPERT_MAX_PARALLEL), busy_sum(0)
+    Expert() : expert_id(-1), num_idle_channel(EXPERT_MAX_PARALLEL), busy_sum(0), busy_since(-1)
     {
         for (int i = 0; i < EXPERT_MAX_PARALLEL; ++i)
             channels[i] = -1;
@@ -100,6 +108,7 @@ struct Expert
             this->expert_id = expt.expert_id;
             this->num_idle_channel = expt.num_idle_channel;
             this->busy_sum = expt.busy_sum;
+            this->busy_since = expt.busy_since;
             for (int i = 0; i < EXPERT_MAX_PARALLEL; ++i)
                 this->channels[i] = expt.channels[i];
             for (int i = 0; i < NUM_TASK_TYPE; ++i)
@@ -107,25 +116,480 @@ struct Expert
         }
         return *this;
     }
+
+    /**
+     * Take an idle channel, the busy time counts from `env_tm` if the expert was idle
+     */
+    void take_channel(int env_tm)
+    {
+        if (num_idle_channel-- == EXPERT_MAX_PARALLEL)
+            busy_since = env_tm;
+    }
+
+    /**
+     * Free a channel, the busy time till `env_tm` (exclusive) is settled if the expert turns idle
+     */
+    void free_channel(int env_tm)
+    {
+        if (++num_idle_channel == EXPERT_MAX_PARALLEL)
+        {
+            busy_sum += env_tm - busy_since;
+            busy_since = -1;
+        }
+    }
+
+    /**
+     * Busy time before `env_tm`, including the unsettled part if the expert is busy now
+     */
+    int busy_time(int env_tm) const
+    {
+        return busy_since == -1 ? busy_sum : busy_sum + env_tm - busy_since;
+    }
+};
+
+/**
+ * One row of a result, the task is assigned to the expert at `tm`, the expert is given by expert id, not idx.
+ * Rows are packed in a std::vector, so a result is one allocation and is copied by one memcpy
+ */
+struct Assignment
+{
+    int task_id;
+    int expert_id;
+    int tm;
+};
+
+/**
+ * Sort result rows by time, then by task id
+ */
+void sort_assignments(std::vector<Assignment> &result)
+{
+    std::sort(result.begin(), result.end(), [](const Assignment &a, const Assignment &b) -> bool {
+        if (a.tm != b.tm)
+            return a.tm < b.tm;
+        else
+            return a.task_id < b.task_id;
+    });
+}
+
+/**
+ * Dense index sets of the experts which have idle channels, one set for all experts and one set for each type
+ * with the suitable experts of the type. Each set keeps expert idxs packed in an array together with the position
+ * of each expert, updated by swap-remove, so a random idle expert can be sampled in O(1)
+ */
+struct IdleExperts
+{
+    int num_types;
+    int num_experts;
+    std::vector<int> all_idle; // idle experts idxs
+    std::vector<int> all_pos;  // position of each expert in `all_idle`, -1 if not idle
+    std::vector<int> group_beg;  // the idle suitable experts of type t are group_idle[group_beg[t], group_beg[t] + group_size[t])
+    std::vector<int> group_size;
+    std::vector<int> group_idle;
+    std::vector<int> group_pos; // position of expert e in group t is group_pos[t * num_experts + e], -1 if not idle or not suitable
+
+    IdleExperts() : num_types(0), num_experts(0) {}
+
+    /**
+     * All experts are idle at the beginning
+     * @param expert_groups: the suitable expert idxs of each type
+     */
+    void init(const std::vector<std::vector<int>> &expert_groups, int _num_experts)
+    {
+        num_types = expert_groups.size();
+        num_experts = _num_experts;
+        all_idle.resize(num_experts);
+        all_pos.resize(num_experts);
+        for (int i = 0; i < num_experts; ++i)
+        {
+            all_idle[i] = i;
+            all_pos[i] = i;
+        }
+        group_beg.assign(num_types + 1, 0);
+        group_size.assign(num_types, 0);
+        for (int t = 0; t < num_types; ++t)
+            group_beg[t + 1] = group_beg[t] + expert_groups[t].size();
+        group_idle.assign(group_beg[num_types], -1);
+        group_pos.assign(num_types * num_experts, -1);
+        for (int t = 0; t < num_types; ++t)
+        {
+            for (int expt_idx : expert_groups[t])
+            {
+                group_pos[t * num_experts + expt_idx] = group_size[t];
+                group_idle[group_beg[t] + group_size[t]++] = expt_idx;
+            }
+        }
+    }
+
+    bool is_idle(int expt_idx, int type = -1) const
+    {
+        return type == -1 ? all_pos[expt_idx] != -1 : group_pos[type * num_experts + expt_idx] != -1;
+    }
+
+    int num_idle(int type = -1) const
+    {
+        return type == -1 ? (int)all_idle.size() : group_size[type];
+    }
+
+    /**
+     * The packed idle experts idxs, `num_idle(type)` valid
+     */
+    const int *idle_list(int type = -1) const
+    {
+        return type == -1 ? all_idle.data() : group_idle.data() + group_beg[type];
+    }
+
+    /**
+     * The expert has a channel released and turns from full to idle
+     */
+    void mark_idle(int expt_idx, const int *process_type_duras)
+    {
+        if (all_pos[expt_idx] != -1)
+            return;
+        all_pos[expt_idx] = all_idle.size();
+        all_idle.push_back(expt_idx);
+        for (int t = 0; t < num_types; ++t)
+        {
+            if (process_type_duras[t] < EXPERT_NOT_GOOD_TIME)
+            {
+                group_pos[t * num_experts + expt_idx] = group_size[t];
+                group_idle[group_beg[t] + group_size[t]++] = expt_idx;
+            }
+        }
+    }
+
+    /**
+     * The last idle channel of the expert is occupied
+     */
+    void mark_full(int expt_idx, const int *process_type_duras)
+    {
+        if (all_pos[expt_idx] == -1)
+            return;
+        int pos = all_pos[expt_idx];
+        all_idle[pos] = all_idle.back();
+        all_pos[all_idle[pos]] = pos;
+        all_idle.pop_back();
+        all_pos[expt_idx] = -1;
+        for (int t = 0; t < num_types; ++t)
+        {
+            if (process_type_duras[t] < EXPERT_NOT_GOOD_TIME)
+            {
+                int *idle = &group_idle[group_beg[t]];
+                pos = group_pos[t * num_experts + expt_idx];
+                idle[pos] = idle[--group_size[t]];
+                group_pos[t * num_experts + idle[pos]] = pos;
+                group_pos[t * num_experts + expt_idx] = -1;
+            }
+        }
+    }
+
+    /**
+     * Uniformly sample an idle expert, from all experts if `type` is -1, else from the suitable experts of the type
+     * the `exclude` expert is never sampled, return -1 immediately if no such idle expert
+     * @param rand_below: callable returns a uniform random integer in [0, n)
+     */
+    template <typename RandBelow>
+    int sample(RandBelow &&rand_below, int type = -1, int exclude = -1) const
+    {
+        const int *idle = idle_list(type);
+        int n = num_idle(type);
+        if (exclude != -1 && is_idle(exclude, type))
+        {
+            // sample from the first n - 1 slots, the excluded one is replaced by the last slot
+            if (n <= 1)
+                return -1;
+            int expt_idx = idle[rand_below(n - 1)];
+            return expt_idx == exclude ? idle[n - 1] : expt_idx;
+        }
+        return n == 0 ? -1 : idle[rand_below(n)];
+    }
+};
+
+/**
+ * Per tick flags of a run, cleared in O(1) by advancing the epoch instead of reallocating
+ */
+struct EpochFlags
+{
+    std::vector<unsigned int> marks;
+    unsigned int epoch;
+
+    EpochFlags(int n) : marks(n, 0), epoch(1) {}
+
+    void clear()
+    {
+        if (++epoch == 0)
+        {
+            std::fill(marks.begin(), marks.end(), 0);
+            epoch = 1;
+        }
+    }
+
+    bool operator[](int i) const
+    {
+        return marks[i] == epoch;
+    }
+
+    void set(int i)
+    {
+        marks[i] = epoch;
+    }
 };
 
+/**
+ * Index of unfinished tasks currently processed by experts not good at their types, bucketed by task type.
+ * Together with the channels of experts, it gives the swap partners of a misplaced task without scanning all tasks
+ */
+struct MisplacedTasks
+{
+    std::vector<std::vector<int>> type_tasks; // misplaced task idxs of each type
+    std::vector<int> pos;                     // position of each task in its type bucket, -1 if not misplaced
+    std::vector<std::vector<int>> good_types; // types each expert is good at
+    std::vector<int> dfs_color;               // scratch of `resolve_migration_cycles`, 0 unvisited, 1 on path, 2 done
+    std::vector<std::pair<int, int>> dfs_path; // (task idx, next neighbor to try)
+    std::vector<int> dfs_touched;
+    std::vector<int> candidates; // scratch of `find_swap_partner`
+    std::vector<int> roots;      // scratch of `resolve_migration_cycles`
+    std::vector<int> snapshot_tasks; // returned by `snapshot`
+    std::vector<int> cycle;
+
+    /**
+     * Index the tasks already assigned, used when the run starts from an intermediate state,
+     * the buckets keep their capacity, so initializing again for another run does not allocate
+     */
+    void init(const std::vector<Task> &tasks, const std::vector<Expert> &experts, int num_types)
+    {
+        type_tasks.resize(num_types);
+        for (std::vector<int> &bucket : type_tasks)
+            bucket.clear();
+        pos.assign(tasks.size(), -1);
+        dfs_color.assign(tasks.size(), 0);
+        good_types.resize(experts.size());
+        for (int i = 0; i < experts.size(); ++i)
+        {
+            good_types[i].clear();
+            for (int t = 0; t < num_types; ++t)
+            {
+                if (experts[i].process_type_duras[t] < EXPERT_NOT_GOOD_TIME)
+                    good_types[i].push_back(t);
+            }
+        }
+        for (int i = 0; i < tasks.size(); ++i)
+            update(tasks, experts, i);
+    }
+
+    bool contains(int task_idx) const
+    {
+        return pos[task_idx] != -1;
+    }
+
+    /**
+     * Misplaced task idxs in ascending order, a copy that stays valid while tasks are re-indexed, until the next call
+     */
+    const std::vector<int> &snapshot()
+    {
+        collect_sorted(snapshot_tasks);
+        return snapshot_tasks;
+    }
+
+    /**
+     * Re-index a task after it was assigned, migrated, swapped or finished
+     */
+    void update(const std::vector<Task> &tasks, const std::vector<Expert> &experts, int task_idx)
+    {
+        const Task &task = tasks[task_idx];
+        bool misplaced = task.curr_migrate_count > 0 && task.finish_tm == -1 &&
+                         experts[task.each_stay_expert_id[task.curr_migrate_count - 1]].process_type_duras[task.type] == EXPERT_NOT_GOOD_TIME;
+        if (misplaced == contains(task_idx))
+            return;
+        std::vector<int> &bucket = type_tasks[task.type];
+        if (misplaced)
+        {
+            pos[task_idx] = bucket.size();
+            bucket.push_back(task_idx);
+        }
+        else
+        {
+            int last = bucket.back();
+            bucket[pos[task_idx]] = last;
+            pos[last] = pos[task_idx];
+            bucket.pop_back();
+            pos[task_idx] = -1;
+        }
+    }
+
+    /**
+     * Find the swap partner of a misplaced task, the candidates are misplaced tasks on experts good at its type
+     * and misplaced tasks of types its current expert is good at, tried in ascending idx order
+     * @param accept: accept(j) returns if task j is taken as partner
+     * @return the partner task idx, -1 if none accepted
+     */
+    template <typename Accept>
+    int find_swap_partner(const std::vector<Task> &tasks, const std::vector<Expert> &experts,
+                          const std::vector<std::vector<int>> &expert_groups, int task_idx, Accept accept)
+    {
+        const Task &task = tasks[task_idx];
+        candidates.clear();
+        for (int expt_idx : expert_groups[task.type])
+        {
+            for (int c = 0; c < EXPERT_MAX_PARALLEL; ++c)
+            {
+                int j = experts[expt_idx].channels[c];
+                if (j != -1 && contains(j))
+                    candidates.push_back(j);
+            }
+        }
+        for (int t : good_types[task.each_stay_expert_id[task.curr_migrate_count - 1]])
+            candidates.insert(candidates.end(), type_tasks[t].begin(), type_tasks[t].end());
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+        for (int j : candidates)
+        {
+            if (j != task_idx && accept(j))
+                return j;
+        }
+        return -1;
+    }
+
+    /**
+     * Break migration cycles among misplaced tasks in one pass. Task i wants to migrate to task j if the current
+     * expert of j is good at the type of i, a cycle of the graph is a rotation in which each task moves onto the
+     * expert of the next one, so all of them land on suitable experts without needing an idle channel.
+     * Disjoint cycles are found by one DFS over the graph, a found cycle is rotated and cut from the path, nodes
+     * finished without reaching the path are never revisited since rotating a cycle only removes edges
+     * @param movable: movable(i) returns if misplaced task i can migrate at this tick
+     * @param rotate: rotate(cycle, size) applies the rotation, cycle[k] moves onto the expert of cycle[(k + 1) % size],
+     *                it must re-index the moved tasks
+     */
+    template <typename Movable, typename Rotate>
+    void resolve_migration_cycles(const std::vector<Task> &tasks, const std::vector<Expert> &experts,
+                                  const std::vector<std::vector<int>> &expert_groups, Movable movable, Rotate rotate)
+    {
+        collect_sorted(roots);
+        for (int root : roots)
+        {
+            if (!contains(root) || dfs_color[root] != 0 || !movable(root))
+                continue;
+            dfs_path.clear();
+            dfs_path.emplace_back(root, 0);
+            dfs_color[root] = 1;
+            dfs_touched.push_back(root);
+            while (!dfs_path.empty())
+            {
+                int i = dfs_path.back().first;
+                const std::vector<int> &group = expert_groups[tasks[i].type];
+                int next = -1;
+                // neighbors are enumerated by (suitable expert, channel)
+                for (int &k = dfs_path.back().second; k < group.size() * EXPERT_MAX_PARALLEL && next == -1; ++k)
+                {
+                    int expt_idx = group[k / EXPERT_MAX_PARALLEL];
+                    int j = experts[expt_idx].channels[k % EXPERT_MAX_PARALLEL];
+                    if (j == -1 || !contains(j) || dfs_color[j] == 2 ||
+                        tasks[j].each_stay_expert_id[tasks[j].curr_migrate_count - 1] != expt_idx || !movable(j))
+                        continue;
+                    next = j;
+                }
+                if (next == -1)
+                {
+                    dfs_color[i] = 2;
+                    dfs_path.pop_back();
+                }
+                else if (dfs_color[next] == 0)
+                {
+                    dfs_color[next] = 1;
+                    dfs_touched.push_back(next);
+                    dfs_path.emplace_back(next, 0);
+                }
+                else
+                {
+                    // back edge, the path from `next` to the top is a cycle
+                    int beg = dfs_path.size() - 1;
+                    while (dfs_path[beg].first != next)
+                        beg--;
+                    cycle.clear();
+                    for (int k = beg; k < dfs_path.size(); ++k)
+                    {
+                        cycle.push_back(dfs_path[k].first);
+                        dfs_color[dfs_path[k].first] = 2;
+                    }
+                    rotate(cycle.data(), (int)cycle.size());
+                    // continue searching from the path below the cycle
+                    dfs_path.resize(beg);
+                }
+            }
+        }
+        for (int i : dfs_touched)
+            dfs_color[i] = 0;
+        dfs_touched.clear();
+    }
+
+    void collect_sorted(std::vector<int> &out) const
+    {
+        out.clear();
+        for (const std::vector<int> &bucket : type_tasks)
+            out.insert(out.end(), bucket.begin(), bucket.end());
+        std::sort(out.begin(), out.end());
+    }
+};
+
+/**
+ * Path of an instance file, the directory of the competition instance is replaced by `dir` if set,
+ * which is the environment variable INSTANCE_DIR by default, e.g. the output directory of instance_gen
+ */
+std::string instance_file(const char *default_path, const char *dir = getenv("INSTANCE_DIR"))
+{
+    if (dir == nullptr || dir[0] == '\0')
+        return default_path;
+    return std::string(dir) + strrchr(default_path, '/');
+}
+
+/**
+ * Open an instance file for reading, exit if it can not be opened
+ */
+FILE *open_instance_file(const char *default_path)
+{
+    std::string path = instance_file(default_path);
+    FILE *fp = fopen(path.c_str(), "r");
+    if (fp == nullptr)
+    {
+        fprintf(stderr, "failed to open instance file %s\n", path.c_str());
+        exit(1);
+    }
+    return fp;
+}
+
 std::vector<Task> load_tasks()
 {
+    PROFILE_SCOPE(profiler::LOAD);
     std::vector<Task> tasks;
-    FILE *fp = fopen(WORK_ORDER, "r");
+    FILE *fp = open_instance_file(WORK_ORDER);
     int task_id, generate_tm, type, max_resp;
     while (fscanf(fp, " %d,%d,%d,%d", &task_id, &generate_tm, &type, &max_resp) != EOF)
+    {
+        if (type < 1 || type > NUM_TASK_TYPE)
+        {
+            fprintf(stderr, "task %d has type %d, this build supports types 1 to %d, build with -DTASK_TYPES=<n>\n",
+                    task_id, type, NUM_TASK_TYPE);
+            exit(1);
+        }
         tasks.emplace_back(Task(task_id, generate_tm, type - 1, max_resp));
+    }
     fclose(fp);
     return tasks;
 }
 
 std::vector<Expert> load_experts()
 {
+    PROFILE_SCOPE(profiler::LOAD);
     std::vector<Expert> experts;
-    FILE *fp = fopen(PROCESS_TM_MAT, "r");
+    FILE *fp = open_instance_file(PROCESS_TM_MAT);
     char *line = nullptr;
-    getline(&line, &PROCESS_TM_FILE_LINE_MAXLEN, fp);
+    // the header is expert_id followed by a column of each type
+    int num_types = getline(&line, &PROCESS_TM_FILE_LINE_MAXLEN, fp) == EOF ? 0 : std::count(line, line + strlen(line), ',');
+    if (num_types != NUM_TASK_TYPE)
+    {
+        fprintf(stderr, "the instance has %d types, this build supports %d, build with -DTASK_TYPES=%d\n", num_types,
+                NUM_TASK_TYPE, num_types);
+        exit(1);
+    }
     int index = 1;
     while (getline(&line, &PROCESS_TM_FILE_LINE_MAXLEN, fp) != EOF)
     {
@@ -134,7 +598,7 @@ std::vector<Expert> load_experts()
         char *e = strtok(line, ",");
         e = strtok(nullptr, ",");
         int i = 0;
-        while (e != nullptr)
+        while (e != nullptr && i < NUM_TASK_TYPE)
         {
             expt.process_type_duras[i++] = atoi(e);
             e = strtok(nullptr, ",");
@@ -0,0 +1,268 @@
+/**
+ * Phase timers and throughput counters of the search methods, compiled in only with -DPROFILE,
+ * otherwise the PROFILE_* macros expand to nothing.
+ * Time is read from the time stamp counter, each thread adds into its own counters, and a reporter thread writes
+ * the totals of all threads as JSON to the file named by the environment variable PROFILE_JSON (profile.json by default)
+ * every PROFILE_INTERVAL seconds (10 by default) and at exit.
+ * Phase times are inclusive, a phase nested in another one, e.g. score in rollout, is counted in both
+ */
+
+#pragma once
+
+#ifdef PROFILE
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(phase) profiler::LapTimer PROFILE_CONCAT(profile_scope_, __LINE__)(phase)
+#define PROFILE_LAPS(name) profiler::LapTimer name
+#define PROFILE_LAP(name, phase) name.lap(phase)
+#define PROFILE_LAP_END(name) name.stop()
+#define PROFILE_COUNT(counter, n) profiler::count(counter, n)
+#else
+#define PROFILE_SCOPE(phase)
+#define PROFILE_LAPS(name)
+#define PROFILE_LAP(name, phase)
+#define PROFILE_LAP_END(name)
+#define PROFILE_COUNT(counter, n)
+#endif
+
+#ifdef PROFILE
+namespace profiler
+{
+
+enum Phase
+{
+    LOAD,
+    GROUP_EXPERTS,
+    FINISH_CHECK,
+    ASSIGN,
+    MIGRATE,
+    SWAP,
+    SCORE,
+    GA_DECODE,
+    MCTS_SELECT,
+    MCTS_EXPAND,
+    MCTS_ROLLOUT,
+    MCTS_EVICT,
+    NUM_PHASES
+};
+
+enum Counter
+{
+    TICKS,       // time slots simulated by the greedy methods
+    EVALUATIONS, // complete solutions scored
+    ROLLOUTS,    // MCTS simulations
+    NUM_COUNTERS
+};
+
+static const char *PHASE_NAMES[NUM_PHASES] = {"load", "group_experts", "finish_check", "assign", "migrate", "swap",
+                                              "score", "ga_decode", "mcts_select", "mcts_expand", "mcts_rollout", "mcts_evict"};
+static const char *COUNTER_NAMES[NUM_COUNTERS] = {"ticks", "evaluations", "rollouts"};
+
+inline uint64_t now_ticks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * Counters of one thread, only the thread adds into them, the reporter reads them without lock
+ */
+struct ThreadStats
+{
+    std::atomic<uint64_t> phase_ticks[NUM_PHASES];
+    std::atomic<uint64_t> phase_calls[NUM_PHASES];
+    std::atomic<uint64_t> counts[NUM_COUNTERS];
+
+    ThreadStats()
+    {
+        for (int i = 0; i < NUM_PHASES; ++i)
+        {
+            phase_ticks[i].store(0, std::memory_order_relaxed);
+            phase_calls[i].store(0, std::memory_order_relaxed);
+        }
+        for (int i = 0; i < NUM_COUNTERS; ++i)
+            counts[i].store(0, std::memory_order_relaxed);
+    }
+
+    static void add(std::atomic<uint64_t> &x, uint64_t v)
+    {
+        x.store(x.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+    }
+};
+
+struct Reporter
+{
+    std::mutex mtx; // guards `stats` and `stopping`
+    std::condition_variable cv;
+    std::vector<std::unique_ptr<ThreadStats>> stats;
+    bool stopping;
+    std::string path;
+    int interval_sec;
+    uint64_t start_ticks;
+    std::chrono::steady_clock::time_point start_tm;
+    std::thread thread;
+
+    Reporter() : stopping(false), path(getenv("PROFILE_JSON") ? getenv("PROFILE_JSON") : "profile.json"),
+                 interval_sec(getenv("PROFILE_INTERVAL") ? atoi(getenv("PROFILE_INTERVAL")) : 10),
+                 start_ticks(now_ticks()), start_tm(std::chrono::steady_clock::now())
+    {
+        thread = std::thread([this]() { report_loop(); });
+    }
+
+    ~Reporter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        cv.notify_one();
+        thread.join();
+        dump();
+    }
+
+    ThreadStats *add_thread()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stats.emplace_back(new ThreadStats());
+        return stats.back().get();
+    }
+
+    void report_loop()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (!cv.wait_for(lock, std::chrono::seconds(std::max(interval_sec, 1)), [this]() { return stopping; }))
+        {
+            lock.unlock();
+            dump();
+            lock.lock();
+        }
+    }
+
+    /**
+     * Write the totals of all threads, time stamp counter ticks are converted to seconds by the rate measured since start
+     */
+    void dump()
+    {
+        uint64_t phase_ticks[NUM_PHASES] = {0}, phase_calls[NUM_PHASES] = {0}, counts[NUM_COUNTERS] = {0};
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (std::unique_ptr<ThreadStats> &s : stats)
+            {
+                for (int i = 0; i < NUM_PHASES; ++i)
+                {
+                    phase_ticks[i] += s->phase_ticks[i].load(std::memory_order_relaxed);
+                    phase_calls[i] += s->phase_calls[i].load(std::memory_order_relaxed);
+                }
+                for (int i = 0; i < NUM_COUNTERS; ++i)
+                    counts[i] += s->counts[i].load(std::memory_order_relaxed);
+            }
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_tm).count();
+        double ticks_per_sec = elapsed > 0 ? (now_ticks() - start_ticks) / elapsed : 1;
+        std::string json = "{\n  \"elapsed_sec\": " + std::to_string(elapsed) + ",\n  \"phases\": {";
+        char buf[256];
+        for (int i = 0; i < NUM_PHASES; ++i)
+        {
+            double sec = phase_ticks[i] / ticks_per_sec;
+            snprintf(buf, sizeof(buf), "%s\n    \"%s\": {\"calls\": %llu, \"sec\": %.6f, \"avg_us\": %.3f}", i == 0 ? "" : ",",
+                     PHASE_NAMES[i], (unsigned long long)phase_calls[i], sec, phase_calls[i] > 0 ? sec * 1e6 / phase_calls[i] : 0);
+            json += buf;
+        }
+        json += "\n  },\n  \"counters\": {";
+        for (int i = 0; i < NUM_COUNTERS; ++i)
+        {
+            snprintf(buf, sizeof(buf), "%s\n    \"%s\": {\"count\": %llu, \"per_sec\": %.3f}", i == 0 ? "" : ",",
+                     COUNTER_NAMES[i], (unsigned long long)counts[i], elapsed > 0 ? counts[i] / elapsed : 0);
+            json += buf;
+        }
+        json += "\n  }\n}\n";
+        std::string tmp_path = path + ".tmp";
+        FILE *fp = fopen(tmp_path.c_str(), "w");
+        if (fp == nullptr)
+            return;
+        fwrite(json.data(), 1, json.size(), fp);
+        fclose(fp);
+        rename(tmp_path.c_str(), path.c_str());
+    }
+};
+
+/**
+ * The reporter of the process, created on first use
+ */
+Reporter &reporter()
+{
+    static Reporter r;
+    return r;
+}
+
+ThreadStats &thread_stats()
+{
+    static thread_local ThreadStats *s = reporter().add_thread();
+    return *s;
+}
+
+void count(Counter counter, uint64_t n)
+{
+    ThreadStats::add(thread_stats().counts[counter], n);
+}
+
+/**
+ * Times consecutive phases, `lap` ends the running phase and starts the next one, the last phase ends with the timer
+ */
+struct LapTimer
+{
+    ThreadStats &stats;
+    int phase;
+    uint64_t start;
+
+    LapTimer() : stats(thread_stats()), phase(-1), start(0) {}
+
+    LapTimer(Phase _phase) : LapTimer()
+    {
+        lap(_phase);
+    }
+
+    ~LapTimer()
+    {
+        stop();
+    }
+
+    void lap(Phase next)
+    {
+        uint64_t now = now_ticks();
+        if (phase != -1)
+            ThreadStats::add(stats.phase_ticks[phase], now - start);
+        ThreadStats::add(stats.phase_calls[next], 1);
+        phase = next;
+        start = now;
+    }
+
+    void stop()
+    {
+        if (phase != -1)
+            ThreadStats::add(stats.phase_ticks[phase], now_ticks() - start);
+        phase = -1;
+    }
+};
+
+} // namespace profiler
+#endif
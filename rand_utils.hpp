@@ -0,0 +1,145 @@
+/**
+ * Random number generation shared by all methods
+ * The generator is xoshiro256**, jobs of a thread pool get generators seeded by the master seed and the job index,
+ * so a run is reproducible from its master seed whichever thread runs each job
+ */
+
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+namespace rand_utils
+{
+
+/**
+ * splitmix64, expands a seed into the generator state
+ */
+uint64_t splitmix64(uint64_t &x)
+{
+    uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * xoshiro256** generator, it satisfies the uniform random bit generator requirements of the standard library
+ */
+struct Xoshiro256
+{
+    typedef uint64_t result_type;
+    uint64_t s[4];
+
+    Xoshiro256(uint64_t seed_val = 0)
+    {
+        seed(seed_val);
+    }
+
+    void seed(uint64_t seed_val)
+    {
+        for (int i = 0; i < 4; ++i)
+            s[i] = splitmix64(seed_val);
+    }
+
+    static constexpr uint64_t min()
+    {
+        return 0;
+    }
+
+    static constexpr uint64_t max()
+    {
+        return UINT64_MAX;
+    }
+
+    static uint64_t rotl(const uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t operator()()
+    {
+        const uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+};
+
+/**
+ * Uniform random integer in [0, n), n > 0
+ * Lemire's multiply-shift method, the division is only taken in the rare case of a possibly biased draw
+ */
+int below(Xoshiro256 &rng, int n)
+{
+    uint64_t range = n;
+    __uint128_t m = (__uint128_t)rng() * range;
+    uint64_t low = (uint64_t)m;
+    if (low < range)
+    {
+        uint64_t threshold = (0 - range) % range;
+        while (low < threshold)
+        {
+            m = (__uint128_t)rng() * range;
+            low = (uint64_t)m;
+        }
+    }
+    return (int)(m >> 64);
+}
+
+/**
+ * Uniform random integer in [low, high]
+ */
+int range(Xoshiro256 &rng, int low, int high)
+{
+    return low + below(rng, high - low + 1);
+}
+
+/**
+ * Uniform random number in [0, 1)
+ */
+double uniform(Xoshiro256 &rng)
+{
+    return (rng() >> 11) * 0x1.0p-53;
+}
+
+/**
+ * True with probability `p`, compares the 53 high bits of a draw against `p` scaled, without converting the draw to double
+ */
+bool bernoulli(Xoshiro256 &rng, double p)
+{
+    if (p <= 0)
+        return false;
+    if (p >= 1)
+        return true;
+    return (rng() >> 11) < (uint64_t)(p * 0x1.0p53);
+}
+
+/**
+ * The generator of a job, seeded from the master seed and the job index, the numbers drawn by a job
+ * do not depend on which thread runs it
+ */
+Xoshiro256 job_stream(uint64_t seed, uint64_t job)
+{
+    uint64_t x = splitmix64(seed) + job;
+    return Xoshiro256(splitmix64(x));
+}
+
+/**
+ * The master seed of a run, taken from the first command line argument if given, otherwise from the clock
+ * The seed is printed so that the run can be reproduced
+ */
+uint64_t master_seed(int argc, char const *argv[])
+{
+    uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 10) : (uint64_t)time(nullptr);
+    printf("master seed=%llu\n", (unsigned long long)seed);
+    return seed;
+}
+
+} // namespace rand_utils
@@ -0,0 +1,153 @@
+/**
+ * Background writer of result csv files, so search threads never wait for the disk
+ * A submitted result is moved into the single pending slot, a result submitted before the pending one is written
+ * is replaced by it, so only the newest result is written when results come faster than the disk takes them.
+ * Each file is written to a temporary file first and renamed, a reader never sees a partly written result
+ */
+
+#pragma once
+#include "monte_utils.hpp"
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace result_writer
+{
+
+/**
+ * Append the decimal text of `val` to `out`
+ */
+char *write_int(char *out, int val)
+{
+    unsigned int u = val;
+    if (val < 0)
+    {
+        *out++ = '-';
+        u = 0u - u;
+    }
+    char digits[10];
+    int n = 0;
+    do
+    {
+        digits[n++] = '0' + u % 10;
+        u /= 10;
+    } while (u != 0);
+    while (n > 0)
+        *out++ = digits[--n];
+    return out;
+}
+
+/**
+ * Format result rows as csv lines "task id,expert id,time"
+ */
+std::string format_rows(const std::vector<monte_utils::Assignment> &result)
+{
+    std::string text(result.size() * 36, '\0'); // each row is at most 3 ints of 11 chars and 3 separators
+    char *out = &text[0];
+    for (const monte_utils::Assignment &row : result)
+    {
+        out = write_int(out, row.task_id);
+        *out++ = ',';
+        out = write_int(out, row.expert_id);
+        *out++ = ',';
+        out = write_int(out, row.tm);
+        *out++ = '\n';
+    }
+    text.resize(out - text.data());
+    return text;
+}
+
+/**
+ * Write `text` to a temporary file and rename it to `filename`
+ */
+bool write_file(const std::string &filename, const std::string &text)
+{
+    std::string tmp_filename = filename + ".tmp";
+    FILE *fp = fopen(tmp_filename.c_str(), "w");
+    if (fp == nullptr)
+        return false;
+    bool ok = fwrite(text.data(), 1, text.size(), fp) == text.size();
+    ok = fclose(fp) == 0 && ok;
+    if (ok && rename(tmp_filename.c_str(), filename.c_str()) == 0)
+        return true;
+    remove(tmp_filename.c_str());
+    return false;
+}
+
+struct ResultWriter
+{
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool has_pending;
+    std::string pending_filename;
+    std::vector<monte_utils::Assignment> pending_result;
+    bool stopping;
+    std::thread thread;
+
+    ResultWriter() : has_pending(false), stopping(false)
+    {
+        thread = std::thread([this]() { write_loop(); });
+    }
+
+    /**
+     * The pending result is written before the writer stops
+     */
+    ~ResultWriter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        cv.notify_one();
+        thread.join();
+    }
+
+    /**
+     * Take over `result` to be written to `filename`, replacing the pending result if it is not written yet
+     */
+    void submit(std::string filename, std::vector<monte_utils::Assignment> result)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            has_pending = true;
+            pending_filename.swap(filename);
+            pending_result.swap(result);
+        }
+        cv.notify_one();
+        // the replaced result is freed here, outside the lock
+    }
+
+    void write_loop()
+    {
+        std::string filename;
+        std::vector<monte_utils::Assignment> result;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [this]() { return has_pending || stopping; });
+                if (!has_pending)
+                    return;
+                has_pending = false;
+                filename.swap(pending_filename);
+                result.swap(pending_result);
+            }
+            if (!write_file(filename, format_rows(result)))
+                fprintf(stderr, "failed to write result %s\n", filename.c_str());
+        }
+    }
+};
+
+/**
+ * The writer of the process, created on first use and drained at exit
+ */
+ResultWriter &global_writer()
+{
+    static ResultWriter writer;
+    return writer;
+}
+
+} // namespace result_writer
@@ -0,0 +1,326 @@
+/**
+ * Shared memory board for processes searching the same instance, enabled by the environment variable SHM_BOARD,
+ * which names the segments under /dev/shm. Two segments are kept:
+ *  <name>.instance: the rows of tasks and experts, written once by the first process and mapped read only by the others
+ *  <name>.incumbent: the best solution and score of all processes, guarded by a seqlock, readers copy it without
+ *   blocking the writer and retry if a write overlapped the copy
+ * Segments stay after the processes exit, so later processes start from the incumbent of earlier ones,
+ * remove /dev/shm/<name>.* to start over or after the instance files change
+ */
+
+#pragma once
+#include "best_board.hpp"
+#include "monte_utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace shm_board
+{
+
+static const int TASK_ROW_LEN = 4;                                   // task id, generate time, type, max response time
+static const int EXPERT_ROW_LEN = monte_utils::NUM_TASK_TYPE + 1;    // expert id, process time of each type
+static const int SOLUTION_ROW_LEN = 3;                               // task id, expert id, assign time
+static const int MAX_SPIN = 100000;                                  // tries before giving up a segment left locked by a dead process
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<double>::is_always_lock_free,
+              "atomics shared by processes must be lock free");
+
+struct InstanceHeader
+{
+    std::atomic<uint32_t> ready; // set after the rows are written
+    uint32_t num_tasks;
+    uint32_t num_experts;
+    uint32_t num_types;
+    // followed by num_tasks task rows and num_experts expert rows
+};
+
+struct IncumbentHeader
+{
+    std::atomic<uint64_t> seq;   // odd while a writer updates the solution
+    std::atomic<double> score;   // read without the seqlock to skip pulls and pushes which can not improve
+    uint32_t num_rows;
+    // followed by the solution rows, at most num_tasks * TASK_MAX_MIGRATION
+};
+
+struct ShmBoard
+{
+    std::string name;
+    const InstanceHeader *instance;
+    size_t instance_bytes;
+    IncumbentHeader *incumbent;
+    size_t incumbent_bytes;
+    uint32_t capacity; // max solution rows
+
+    ShmBoard(const char *_name) : name(_name ? _name : ""), instance(nullptr), instance_bytes(0), incumbent(nullptr),
+                                  incumbent_bytes(0), capacity(0)
+    {
+        if (name.empty())
+            return;
+        if (!open_instance() || !open_incumbent())
+        {
+            fprintf(stderr, "shm board %s not available, searching alone\n", name.c_str());
+            close();
+        }
+    }
+
+    ~ShmBoard()
+    {
+        close();
+    }
+
+    bool enabled() const
+    {
+        return incumbent != nullptr;
+    }
+
+    void close()
+    {
+        if (instance)
+            munmap((void *)instance, instance_bytes);
+        if (incumbent)
+            munmap(incumbent, incumbent_bytes);
+        instance = nullptr;
+        incumbent = nullptr;
+    }
+
+    const int *task_rows() const
+    {
+        return (const int *)(instance + 1);
+    }
+
+    const int *expert_rows() const
+    {
+        return task_rows() + instance->num_tasks * TASK_ROW_LEN;
+    }
+
+    int *solution_rows() const
+    {
+        return (int *)(incumbent + 1);
+    }
+
+    /**
+     * Create the instance segment from the instance files, or map the one created by another process
+     */
+    bool open_instance()
+    {
+        std::string path = "/" + name + ".instance";
+        int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd != -1)
+        {
+            std::vector<monte_utils::Task> tasks = monte_utils::load_tasks();
+            std::vector<monte_utils::Expert> experts = monte_utils::load_experts();
+            instance_bytes = sizeof(InstanceHeader) + sizeof(int) * (tasks.size() * TASK_ROW_LEN + experts.size() * EXPERT_ROW_LEN);
+            void *addr = ftruncate(fd, instance_bytes) == 0 ? mmap(nullptr, instance_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+            ::close(fd);
+            if (addr == MAP_FAILED)
+            {
+                shm_unlink(path.c_str());
+                return false;
+            }
+            InstanceHeader *header = (InstanceHeader *)addr;
+            header->num_tasks = tasks.size();
+            header->num_experts = experts.size();
+            header->num_types = monte_utils::NUM_TASK_TYPE;
+            int *rows = (int *)(header + 1);
+            for (const monte_utils::Task &task : tasks)
+            {
+                *rows++ = task.task_id;
+                *rows++ = task.generate_tm;
+                *rows++ = task.type;
+                *rows++ = task.max_resp;
+            }
+            for (const monte_utils::Expert &expert : experts)
+            {
+                *rows++ = expert.expert_id;
+                rows = std::copy(expert.process_type_duras, expert.process_type_duras + monte_utils::NUM_TASK_TYPE, rows);
+            }
+            header->ready.store(1, std::memory_order_release);
+            mprotect(addr, instance_bytes, PROT_READ);
+            instance = header;
+        }
+        else
+        {
+            if (errno != EEXIST || (fd = shm_open(path.c_str(), O_RDONLY, 0)) == -1)
+                return false;
+            // the creator sizes the segment before writing it
+            struct stat st;
+            for (int i = 0; fstat(fd, &st) == 0 && st.st_size == 0 && i < MAX_SPIN; ++i)
+                std::this_thread::yield();
+            instance_bytes = st.st_size;
+            void *addr = instance_bytes > 0 ? mmap(nullptr, instance_bytes, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+            ::close(fd);
+            if (addr == MAP_FAILED)
+                return false;
+            instance = (const InstanceHeader *)addr;
+            for (int i = 0; instance->ready.load(std::memory_order_acquire) == 0; ++i)
+            {
+                if (i == MAX_SPIN)
+                    return false;
+                usleep(100);
+            }
+            if (instance->num_types != monte_utils::NUM_TASK_TYPE)
+                return false;
+        }
+        capacity = instance->num_tasks * monte_utils::TASK_MAX_MIGRATION;
+        return true;
+    }
+
+    /**
+     * Create or map the incumbent segment, a new segment is all zeros, which is an empty incumbent
+     */
+    bool open_incumbent()
+    {
+        std::string path = "/" + name + ".incumbent";
+        int fd = shm_open(path.c_str(), O_CREAT | O_RDWR, 0644);
+        if (fd == -1)
+            return false;
+        incumbent_bytes = sizeof(IncumbentHeader) + sizeof(int) * capacity * SOLUTION_ROW_LEN;
+        struct stat st;
+        bool sized = fstat(fd, &st) == 0 && (st.st_size == (off_t)incumbent_bytes || (st.st_size == 0 && ftruncate(fd, incumbent_bytes) == 0));
+        void *addr = sized ? mmap(nullptr, incumbent_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        ::close(fd);
+        if (addr == MAP_FAILED)
+            return false;
+        incumbent = (IncumbentHeader *)addr;
+        return true;
+    }
+
+    std::vector<monte_utils::Task> load_tasks() const
+    {
+        if (!instance)
+            return monte_utils::load_tasks();
+        std::vector<monte_utils::Task> tasks;
+        tasks.reserve(instance->num_tasks);
+        for (const int *row = task_rows(); row != expert_rows(); row += TASK_ROW_LEN)
+            tasks.emplace_back(monte_utils::Task(row[0], row[1], row[2], row[3]));
+        return tasks;
+    }
+
+    std::vector<monte_utils::Expert> load_experts() const
+    {
+        if (!instance)
+            return monte_utils::load_experts();
+        std::vector<monte_utils::Expert> experts(instance->num_experts);
+        const int *row = expert_rows();
+        for (monte_utils::Expert &expert : experts)
+        {
+            expert.expert_id = row[0];
+            std::copy(row + 1, row + EXPERT_ROW_LEN, expert.process_type_duras);
+            row += EXPERT_ROW_LEN;
+        }
+        return experts;
+    }
+
+    /**
+     * Best score of all processes, 0 if disabled
+     */
+    double score() const
+    {
+        return enabled() ? incumbent->score.load(std::memory_order_acquire) : 0;
+    }
+
+    /**
+     * Publish a solution if it beats the shared incumbent
+     * @return true if the solution became the shared incumbent
+     */
+    bool push(double score, const std::vector<monte_utils::Assignment> &solution)
+    {
+        if (!enabled() || score <= this->score() || solution.size() > capacity)
+            return false;
+        uint64_t seq = incumbent->seq.load(std::memory_order_relaxed);
+        for (int i = 0; (seq & 1) || !incumbent->seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire); ++i)
+        {
+            if (i == MAX_SPIN)
+                return false;
+            std::this_thread::yield();
+            seq = incumbent->seq.load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        bool better = score > incumbent->score.load(std::memory_order_relaxed);
+        if (better)
+        {
+            int *rows = solution_rows();
+            for (const monte_utils::Assignment &row : solution)
+            {
+                __atomic_store_n(rows++, row.task_id, __ATOMIC_RELAXED);
+                __atomic_store_n(rows++, row.expert_id, __ATOMIC_RELAXED);
+                __atomic_store_n(rows++, row.tm, __ATOMIC_RELAXED);
+            }
+            __atomic_store_n(&incumbent->num_rows, (uint32_t)solution.size(), __ATOMIC_RELAXED);
+            incumbent->score.store(score, std::memory_order_relaxed);
+        }
+        incumbent->seq.store(seq + 2, std::memory_order_release);
+        return better;
+    }
+
+    /**
+     * Copy the shared incumbent, nullptr if disabled, empty, or locked by a dead writer
+     */
+    std::shared_ptr<best_board::Incumbent> pull() const
+    {
+        if (!enabled())
+            return nullptr;
+        std::shared_ptr<best_board::Incumbent> inc = std::make_shared<best_board::Incumbent>();
+        const int *rows = solution_rows();
+        for (int i = 0; i < MAX_SPIN; ++i)
+        {
+            uint64_t seq = incumbent->seq.load(std::memory_order_acquire);
+            if (seq & 1)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            inc->score = incumbent->score.load(std::memory_order_relaxed);
+            uint32_t num_rows = std::min(__atomic_load_n(&incumbent->num_rows, __ATOMIC_RELAXED), capacity);
+            inc->solution.resize(num_rows);
+            for (uint32_t r = 0; r < num_rows; ++r)
+            {
+                const int *row = rows + r * SOLUTION_ROW_LEN;
+                inc->solution[r].task_id = __atomic_load_n(row, __ATOMIC_RELAXED);
+                inc->solution[r].expert_id = __atomic_load_n(row + 1, __ATOMIC_RELAXED);
+                inc->solution[r].tm = __atomic_load_n(row + 2, __ATOMIC_RELAXED);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (incumbent->seq.load(std::memory_order_relaxed) == seq)
+                return num_rows > 0 ? inc : nullptr;
+        }
+        return nullptr;
+    }
+
+    /**
+     * Adopt the shared incumbent into `board` if it beats the board's best
+     * @return the adopted incumbent, nullptr if nothing is adopted
+     */
+    std::shared_ptr<best_board::Incumbent> sync(best_board::BestBoard &board) const
+    {
+        if (score() <= board.score())
+            return nullptr;
+        std::shared_ptr<best_board::Incumbent> inc = pull();
+        return inc && board.adopt(*inc) ? inc : nullptr;
+    }
+};
+
+/**
+ * The board of the process, opened on first use, disabled unless SHM_BOARD is set
+ */
+ShmBoard &global_board()
+{
+    static ShmBoard board(getenv("SHM_BOARD"));
+    return board;
+}
+
+} // namespace shm_board
@@ -0,0 +1,214 @@
+/**
+ * This file is using simple SPT strategy as the benchmark
+ * The shortest processing time rule orders the jobs in the order of increasing processing times.
+ * Whenever a machine is freed, the shortest job ready at the time will begin processing.
+ */
+
+#pragma once
+#include "monte_metrics.hpp"
+#include "monte_utils.hpp"
+#include "profiler.hpp"
+#include "result_writer.hpp"
+#include <vector>
+#include <algorithm>
+#include <ctime>
+
+namespace spt
+{
+
+// Group the tasks by their type
+// Each row corresponds to one type
+std::vector<std::vector<monte_utils::Task *>> task_groupby_type(int num_types, std::vector<monte_utils::Task> &tasks)
+{
+    std::vector<std::vector<monte_utils::Task *>> group_tasks(num_types);
+    for (int i = 0; i < tasks.size(); ++i)
+    {
+        int task_type = tasks[i].type;
+        group_tasks[task_type].push_back(&tasks[i]);
+    }
+    return group_tasks;
+}
+
+// Sort the order of tasks in each group by the generating time and response time
+void task_sort_each_group_by_tm_resptm(std::vector<std::vector<monte_utils::Task *>> &group_tasks)
+{
+    int size = group_tasks.size();
+    for (int i = 0; i < size; ++i)
+    {
+        std::sort(group_tasks[i].begin(), group_tasks[i].end(), [](monte_utils::Task *a, monte_utils::Task *b) -> bool {
+            if (a->generate_tm != b->generate_tm)
+                return a->generate_tm < b->generate_tm;
+            else if (a->max_resp != b->max_resp)
+                return a->max_resp < b->max_resp;
+            else
+                return a->task_id < b->task_id;
+        });
+    }
+}
+
+// Group experts by their types
+// The return result is a two dimension vector, each row corresponds to one type, and each value in a row is the expert index
+std::vector<std::vector<int>> expert_group_by_type(int num_types, std::vector<monte_utils::Expert> &experts)
+{
+    PROFILE_SCOPE(profiler::GROUP_EXPERTS);
+    std::vector<std::vector<int>> group_experts(num_types);
+    for (int i = 0; i < experts.size(); ++i)
+    {
+        for (int j = 0; j < num_types; ++j)
+        {
+            if (experts[i].process_type_duras[j] < monte_utils::EXPERT_NOT_GOOD_TIME)
+            {
+                group_experts[j].push_back(i);
+            }
+        }
+    }
+    return group_experts;
+}
+
+// Sort experts in each group by their processing time
+void expert_sort_each_group_by_processtm(std::vector<std::vector<int>> &group_experts, std::vector<monte_utils::Expert> &experts)
+{
+    for (int i = 0; i < group_experts.size(); ++i)
+    {
+        std::sort(group_experts[i].begin(), group_experts[i].end(), [&experts, i](int &a, int &b) -> bool {
+            return experts[a].process_type_duras[i] < experts[b].process_type_duras[i];
+        });
+    }
+}
+
+// Assign the task to an idle channel of the expert at time `env_tm`
+// Return false if the expert has no idle channel
+bool assign_task(std::vector<monte_utils::Task> &tasks, std::vector<monte_utils::Expert> &experts, int task_idx, int expt_idx, int env_tm)
+{
+    monte_utils::Expert &expert = experts[expt_idx];
+    if (expert.num_idle_channel <= 0)
+        return false;
+    monte_utils::Task &task = tasks[task_idx];
+    task.start_process_tm = env_tm;
+    task.each_stay_expert_id[task.curr_migrate_count] = expt_idx;
+    task.assign_tm[task.curr_migrate_count] = env_tm;
+    task.curr_migrate_count++;
+    for (int i = 0; i < monte_utils::EXPERT_MAX_PARALLEL; ++i)
+    {
+        if (expert.channels[i] == -1)
+        {
+            expert.channels[i] = task_idx;
+            expert.take_channel(env_tm);
+            break;
+        }
+    }
+    return true;
+}
+
+// The time elapsed one time slot, the tasks finished at `env_tm` leave the expert
+// Return the number of finished tasks
+int update_expert(std::vector<monte_utils::Task> &tasks, monte_utils::Expert &expert, int env_tm)
+{
+    int num_finish = 0;
+    for (int i = 0; i < monte_utils::EXPERT_MAX_PARALLEL; ++i)
+    {
+        if (expert.channels[i] == -1)
+            continue;
+        monte_utils::Task &task = tasks[expert.channels[i]];
+        if (task.assign_tm[task.curr_migrate_count - 1] + expert.process_type_duras[task.type] <= env_tm)
+        {
+            task.finish_tm = env_tm;
+            expert.channels[i] = -1;
+            expert.free_channel(env_tm);
+            num_finish++;
+        }
+    }
+    return num_finish;
+}
+
+// Shortest Process Time strategy
+// Tasks are grouped by type, generated tasks of each type wait in a queue ordered by their deadline(generating time + max response time)
+// Experts are also grouped by types which they good at, each expert may belong to multiple groups
+// In algorithm, the queue of each type is drained to the corresponding type group experts while the group has idle channels,
+// which is tracked by a per type idle channel counter, so a task never waits behind another one of its type when channels are idle
+// If experts are all busy, the tasks need to wait.
+std::vector<monte_utils::Assignment> spt_run(std::vector<monte_utils::Task> &tasks, std::vector<monte_utils::Expert> &experts,
+                                             std::vector<std::vector<monte_utils::Task *>> &group_tasks,
+                                             std::vector<std::vector<int>> &group_experts)
+{
+    std::vector<monte_utils::Assignment> result; // each row is task id, expert id, task start processing time
+    result.reserve(tasks.size());
+    std::vector<int> suit_expt_idxs; // reused by each assignment, only grows to the largest group
+    int num_left_tasks = tasks.size();
+    int num_types = group_tasks.size();
+    std::vector<int> task_group_progresses(num_types, 0); // tasks before the progress have been put into the ready queue
+    // the ready queue of each type, earliest deadline on top
+    auto later_deadline = [](const monte_utils::Task *a, const monte_utils::Task *b) -> bool {
+        if (a->generate_tm + a->max_resp != b->generate_tm + b->max_resp)
+            return a->generate_tm + a->max_resp > b->generate_tm + b->max_resp;
+        else
+            return a->task_id > b->task_id;
+    };
+    std::vector<std::vector<monte_utils::Task *>> ready_tasks(num_types);
+    // the number of idle channels of experts good at each type, and the types each expert is good at
+    std::vector<int> type_idle_channels(num_types, 0);
+    std::vector<std::vector<int>> expert_types(experts.size());
+    for (int i = 0; i < num_types; ++i)
+    {
+        for (int expt_idx : group_experts[i])
+        {
+            type_idle_channels[i] += experts[expt_idx].num_idle_channel;
+            expert_types[expt_idx].push_back(i);
+        }
+    }
+    int env_tm = 0; // time slots
+    while (num_left_tasks > 0)
+    {
+        for (int i = 0; i < num_types; ++i)
+        {
+            // Task can only be assigned to expert when reaching the generating time stamp
+            while (task_group_progresses[i] < group_tasks[i].size() && group_tasks[i][task_group_progresses[i]]->generate_tm <= env_tm)
+            {
+                ready_tasks[i].push_back(group_tasks[i][task_group_progresses[i]++]);
+                std::push_heap(ready_tasks[i].begin(), ready_tasks[i].end(), later_deadline);
+            }
+            while (!ready_tasks[i].empty() && type_idle_channels[i] > 0)
+            {
+                // Try assign task to expert
+                monte_utils::Task *curr_task = ready_tasks[i].front();
+                int task_type = curr_task->type;
+                suit_expt_idxs.assign(group_experts[task_type].begin(), group_experts[task_type].end());
+                std::sort(suit_expt_idxs.begin(),suit_expt_idxs.end(),[&experts,task_type,env_tm](const int a, const int b)->bool{
+                    if(experts[a].process_type_duras[task_type] != experts[b].process_type_duras[task_type])
+                        return experts[a].process_type_duras[task_type] < experts[b].process_type_duras[task_type];
+                    else if(experts[a].busy_time(env_tm) != experts[b].busy_time(env_tm))
+                        return experts[a].busy_time(env_tm) < experts[b].busy_time(env_tm);
+                    else if(experts[a].num_idle_channel != experts[b].num_idle_channel)
+                        return experts[a].num_idle_channel > experts[b].num_idle_channel;
+                    else
+                        return experts[a].expert_id < experts[b].expert_id;
+                });
+                for (int expt_idx : suit_expt_idxs)
+                {
+                    if (assign_task(tasks, experts, curr_task - tasks.data(), expt_idx, env_tm))
+                    {
+                        // Successful assign this task to the expert
+                        std::pop_heap(ready_tasks[i].begin(), ready_tasks[i].end(), later_deadline);
+                        ready_tasks[i].pop_back();
+                        for (int t : expert_types[expt_idx])
+                            type_idle_channels[t]--;
+                        result.push_back({curr_task->task_id, experts[expt_idx].expert_id, env_tm});
+                        break;
+                    }
+                }
+            }
+        }
+        env_tm++;
+        // Put forward one time slot
+        for (int i = 0; i < experts.size(); ++i)
+        {
+            int num_finish = update_expert(tasks, experts[i], env_tm);
+            num_left_tasks -= num_finish;
+            for (int t : expert_types[i])
+                type_idle_channels[t] += num_finish;
+        }
+    }
+    return result;
+}
+
+} // namespace spt
@@ -0,0 +1,229 @@
+/**
+ * Work stealing thread pool shared by the search methods
+ * Each worker owns a deque of jobs, it takes its own jobs from the back and steals from the front of the other deques
+ * when its deque is empty, so jobs of uneven length keep all workers busy instead of waiting at a barrier.
+ * The pool is created once per process, so the jobs of different methods can be mixed in it
+ */
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace thread_pool
+{
+
+struct ThreadPool
+{
+    struct JobQueue
+    {
+        std::mutex mtx;
+        std::deque<std::function<void()>> jobs;
+    };
+
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<JobQueue>> queues; // one for each worker
+    std::atomic<int> num_queued;                   // jobs in all deques
+    std::atomic<unsigned int> next_queue;          // deque receiving the next job submitted from outside the pool
+    std::mutex sleep_mtx;
+    std::condition_variable sleep_cv; // notified when a job is queued, a batch finishes or the pool stops
+    bool stopping;
+
+    /**
+     * @param num_threads: the number of workers, at least 1
+     * @param pin_cpus: pin worker i to cpu i modulo the number of cpus, only supported on linux
+     */
+    ThreadPool(int num_threads, bool pin_cpus = false) : num_queued(0), next_queue(0), stopping(false)
+    {
+        num_threads = std::max(num_threads, 1);
+        for (int i = 0; i < num_threads; ++i)
+            queues.emplace_back(new JobQueue());
+        for (int i = 0; i < num_threads; ++i)
+        {
+            threads.emplace_back([this, i]() { worker_loop(i); });
+#ifdef __linux__
+            if (pin_cpus)
+            {
+                cpu_set_t cpus;
+                CPU_ZERO(&cpus);
+                CPU_SET(i % std::max((int)std::thread::hardware_concurrency(), 1), &cpus);
+                pthread_setaffinity_np(threads.back().native_handle(), sizeof(cpu_set_t), &cpus);
+            }
+#endif
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mtx);
+            stopping = true;
+        }
+        sleep_cv.notify_all();
+        for (std::thread &t : threads)
+            t.join();
+    }
+
+    int size() const
+    {
+        return threads.size();
+    }
+
+    /**
+     * Index of the calling thread among the workers, -1 for threads outside the pool
+     */
+    static int &worker_index()
+    {
+        static thread_local int idx = -1;
+        return idx;
+    }
+
+    /**
+     * Slot of the calling thread for per thread states of jobs, workers take [0, size()), and threads outside the pool,
+     * which run jobs while waiting in `parallel_for`, share the slot size()
+     */
+    int slot() const
+    {
+        return worker_index() == -1 ? size() : worker_index();
+    }
+
+    /**
+     * Queue a job without waking sleeping threads, a worker queues into its own deque,
+     * other threads deal jobs to the deques round robin
+     */
+    void push(std::function<void()> job)
+    {
+        int idx = worker_index();
+        if (idx == -1)
+            idx = next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+        {
+            std::lock_guard<std::mutex> lock(queues[idx]->mtx);
+            queues[idx]->jobs.push_back(std::move(job));
+        }
+        num_queued.fetch_add(1, std::memory_order_release);
+    }
+
+    void submit(std::function<void()> job)
+    {
+        push(std::move(job));
+        wake();
+    }
+
+    /**
+     * Run `func(i)` for i in [0, n) as jobs of the pool and wait for all of them
+     * The calling thread runs queued jobs while waiting, so it may also be called from a job.
+     * Jobs keeping state by `slot()` must not call it, since the waiting thread may run another job of the same slot
+     */
+    template <typename Func>
+    void parallel_for(int n, Func func)
+    {
+        if (n <= 0)
+            return;
+        std::atomic<int> remaining(n);
+        Func *f = &func;
+        std::atomic<int> *left = &remaining;
+        for (int i = 0; i < n; ++i)
+        {
+            push([this, f, left, i]() {
+                (*f)(i);
+                if (left->fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    wake();
+            });
+        }
+        wake();
+        while (remaining.load(std::memory_order_acquire) > 0)
+        {
+            if (run_one(worker_index()))
+                continue;
+            std::unique_lock<std::mutex> lock(sleep_mtx);
+            sleep_cv.wait(lock, [&]() {
+                return remaining.load(std::memory_order_acquire) == 0 || num_queued.load(std::memory_order_acquire) > 0;
+            });
+        }
+    }
+
+    /**
+     * Take one job, from the back of the own deque first, then from the front of the others, and run it
+     * @return false if all deques are empty
+     */
+    bool run_one(int idx)
+    {
+        std::function<void()> job;
+        int n = queues.size();
+        int beg = idx == -1 ? next_queue.load(std::memory_order_relaxed) % n : idx;
+        for (int k = 0; k < n && !job; ++k)
+        {
+            JobQueue &q = *queues[(beg + k) % n];
+            std::lock_guard<std::mutex> lock(q.mtx);
+            if (q.jobs.empty())
+                continue;
+            if (k == 0 && idx != -1)
+            {
+                job = std::move(q.jobs.back());
+                q.jobs.pop_back();
+            }
+            else
+            {
+                job = std::move(q.jobs.front());
+                q.jobs.pop_front();
+            }
+        }
+        if (!job)
+            return false;
+        num_queued.fetch_sub(1, std::memory_order_acq_rel);
+        job();
+        return true;
+    }
+
+    /**
+     * Wake all sleeping threads, both workers and threads waiting in `parallel_for` sleep on the same condition,
+     * the mutex is taken so that a thread checking its wait condition can not miss the notification
+     */
+    void wake()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mtx);
+        }
+        sleep_cv.notify_all();
+    }
+
+    void worker_loop(int idx)
+    {
+        worker_index() = idx;
+        while (true)
+        {
+            if (run_one(idx))
+                continue;
+            std::unique_lock<std::mutex> lock(sleep_mtx);
+            sleep_cv.wait(lock, [this]() { return stopping || num_queued.load(std::memory_order_acquire) > 0; });
+            if (stopping && num_queued.load(std::memory_order_acquire) == 0)
+                return;
+        }
+    }
+};
+
+/**
+ * The pool of the process, created on first use
+ * The number of workers is taken from the environment variable POOL_THREADS, by default the number of cpus,
+ * and workers are pinned to cpus if POOL_PIN_CPUS=1
+ */
+ThreadPool &global_pool()
+{
+    static ThreadPool pool(getenv("POOL_THREADS") ? atoi(getenv("POOL_THREADS")) : (int)std::thread::hardware_concurrency(),
+                           getenv("POOL_PIN_CPUS") && atoi(getenv("POOL_PIN_CPUS")) == 1);
+    return pool;
+}
+
+} // namespace thread_pool
@@ -110,7 +110,8 @@ namespace utils
         int process_remains[EXPERT_MAX_PARALLEL];
         int num_avail;
         // variables for record
-        int busy_total_time; // the total time of expert processing coming tasks
+        int busy_total_time; // the total time of expert processing coming tasks, settled when the expert turns idle
+        int busy_since;      // the time the expert last turned from idle to busy, -1 while idle
 
         Expert()
         {
@@ -120,6 +121,7 @@ namespace utils
             num_avail = EXPERT_MAX_PARALLEL;
             id = 0;
             busy_total_time = 0;
+            busy_since = -1;
         }
         ~Expert()
         {
@@ -149,6 +151,7 @@ namespace utils
                 }
                 this->num_avail = expt.num_avail;
                 this->busy_total_time = expt.busy_total_time;
+                this->busy_since = expt.busy_since;
             }
             return *this;
         }
@@ -167,8 +170,31 @@ namespace utils
             return process_dura.size();
         }
 
+        // Take an idle channel at time `tmpt`, the busy time counts from `tmpt` if the expert was idle
+        void take_channel(int tmpt)
+        {
+            if (num_avail-- == EXPERT_MAX_PARALLEL)
+                busy_since = tmpt;
+        }
+
+        // Free a channel at time `tmpt`, the busy time is settled if the expert turns idle
+        void free_channel(int tmpt)
+        {
+            if (++num_avail == EXPERT_MAX_PARALLEL)
+            {
+                busy_total_time += tmpt - busy_since;
+                busy_since = -1;
+            }
+        }
+
+        // Busy time before `tmpt`, including the unsettled part if the expert is busy now
+        int busy_time(int tmpt) const
+        {
+            return busy_since == -1 ? busy_total_time : busy_total_time + tmpt - busy_since;
+        }
+
         // Assign new task to current task
-        bool monte_assign_task(int task_idx)
+        bool monte_assign_task(int task_idx, int tmpt)
         {
             if (num_avail <= 0)
                 return false;
@@ -177,7 +203,7 @@ namespace utils
                 if (process_tasks_idxs[i] == -1)
                 {
                     process_tasks_idxs[i] = task_idx;
-                    num_avail--;
+                    take_channel(tmpt);
                     break;
                 }
             }
@@ -185,7 +211,7 @@ namespace utils
         }
 
         // A task leave the expert, it may be due to finishing or migration
-        bool monte_release_task(int task_idx)
+        bool monte_release_task(int task_idx, int tmpt)
         {
             bool flag = false;
             for (int i = 0; i < EXPERT_MAX_PARALLEL; ++i)
@@ -193,7 +219,7 @@ namespace utils
                 if (process_tasks_idxs[i] == task_idx)
                 {
                     process_tasks_idxs[i] = -1;
-                    num_avail++;
+                    free_channel(tmpt);
                     flag = true;
                     break;
                 }
@@ -201,43 +227,35 @@ namespace utils
             return flag;
         }
 
-        // Env time on slot forward
-        void monte_one_tick()
-        {
-            if (num_avail < EXPERT_MAX_PARALLEL)
-                busy_total_time++;
-        }
-
         // The time elapsed one time slot, the expert process each task one time slot
-        // Update the remains time
-        std::vector<Task *> update(int tmpt)
+        // Update the remains time, the finished tasks are written to `finish_tasks` if given
+        // Return the number of finished tasks
+        int update(int tmpt, Task **finish_tasks = nullptr)
         {
-            std::vector<Task *> finish_tasks;
-            bool is_working = false;
+            int num_finish = 0;
             for (int i = 0; i < EXPERT_MAX_PARALLEL; ++i)
             {
                 // The recoding of last expert_dura and finish_tmpt may be different if using other strategy
                 if (process_tasks[i])
                 {
-                    is_working = true;
                     Task *tsk = process_tasks[i];
                     process_remains[i]--;
                     if (process_remains[i] <= 0)
                     {
-                        finish_tasks.push_back(tsk);
+                        if (finish_tasks)
+                            finish_tasks[num_finish] = tsk;
+                        num_finish++;
                         tsk->each_stay_dura.push_back(this->process_dura[tsk->type]);
                         tsk->finish_tmpt = tmpt;
                         process_tasks[i] = nullptr;
-                        num_avail++;
+                        free_channel(tmpt);
                     }
                 }
             }
-            if (is_working)
-                this->busy_total_time++;
-            return finish_tasks;
+            return num_finish;
         }
 
-        bool assign_task(Task *task)
+        bool assign_task(Task *task, int tmpt)
         {
             if (num_avail <= 0)
                 return false;
@@ -249,10 +267,10 @@ namespace utils
                 {
                     process_remains[i] = process_time;
                     process_tasks[i] = task;
+                    take_channel(tmpt);
                     break;
                 }
             }
-            num_avail--;
             return true;
         }
     };